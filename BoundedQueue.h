@@ -0,0 +1,130 @@
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * BoundedQueue.h                                                                               *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   A fixed capacity queue connecting two threads.
+
+   push() blocks while the queue is full
+   and pop() blocks while it is empty, so a
+   fast stage can't run ahead of a slow one
+   and fill up memory.
+
+   close() is called by the producer when it
+   has nothing left to push, or by anyone to
+   abort the pipeline. After close(), push()
+   fails and pop() drains what is left before
+   it fails.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+template <typename T>
+class BoundedQueue {
+
+	public:
+
+		/*
+		   capacity-> max amount of queued items.
+		   Values < 1 are treated as 1
+		 */
+		explicit BoundedQueue(size_t capacity)
+				: capacity(capacity ? capacity : 1), closed(false) {}
+
+		BoundedQueue(const BoundedQueue& other) = delete;
+		BoundedQueue& operator=(const BoundedQueue& other) = delete;
+
+		/*
+		   Moves item into the queue.
+
+		   Returns:
+		   true-> item was queued
+		   false-> queue was closed, item is dropped
+		 */
+		bool push(T&& item) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [this] {
+				return closed || items.size() < capacity;
+			});
+
+			if (closed) {
+				return false;
+			}
+
+			items.push_back(std::move(item));
+			lock.unlock();
+			notEmpty.notify_one();
+
+			return true;
+		}
+
+		/*
+		   Moves the oldest item into item.
+
+		   Returns:
+		   true-> item was set
+		   false-> queue is closed and empty
+		 */
+		bool pop(T& item) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this] {
+				return closed || !items.empty();
+			});
+
+			if (items.empty()) {
+				return false;
+			}
+
+			item = std::move(items.front());
+			items.pop_front();
+			lock.unlock();
+			notFull.notify_one();
+
+			return true;
+		}
+
+		void close() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closed = true;
+			}
+
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+
+	private:
+
+		size_t capacity;
+		bool closed;
+		std::deque<T> items;
+		std::mutex mutex;
+		std::condition_variable notFull;
+		std::condition_variable notEmpty;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "Gemm.h"
+
+/*
+   The widest vector the target has. Gemm::NR
+   is two of them, so the kernel's accumulators
+   are 8 named variables the compiler keeps in
+   registers at any optimization level.
+ */
+#if defined(__AVX512F__)
+typedef __m512d Vector;
+static inline Vector load(const double* p) { return _mm512_loadu_pd(p); }
+static inline Vector broadcast(double e) { return _mm512_set1_pd(e); }
+static inline Vector zero() { return _mm512_setzero_pd(); }
+static inline void store(double* p, Vector v) { _mm512_storeu_pd(p, v); }
+static inline Vector multiplyAdd(Vector a, Vector b, Vector c) {
+	return _mm512_fmadd_pd(a, b, c);
+}
+#elif defined(__AVX__)
+typedef __m256d Vector;
+static inline Vector load(const double* p) { return _mm256_loadu_pd(p); }
+static inline Vector broadcast(double e) { return _mm256_set1_pd(e); }
+static inline Vector zero() { return _mm256_setzero_pd(); }
+static inline void store(double* p, Vector v) { _mm256_storeu_pd(p, v); }
+static inline Vector multiplyAdd(Vector a, Vector b, Vector c) {
+#if defined(__FMA__)
+	return _mm256_fmadd_pd(a, b, c);
+#else
+	return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+#elif defined(__SSE2__)
+typedef __m128d Vector;
+static inline Vector load(const double* p) { return _mm_loadu_pd(p); }
+static inline Vector broadcast(double e) { return _mm_set1_pd(e); }
+static inline Vector zero() { return _mm_setzero_pd(); }
+static inline void store(double* p, Vector v) { _mm_storeu_pd(p, v); }
+static inline Vector multiplyAdd(Vector a, Vector b, Vector c) {
+	return _mm_add_pd(_mm_mul_pd(a, b), c);
+}
+#else
+typedef double Vector;
+static inline Vector load(const double* p) { return *p; }
+static inline Vector broadcast(double e) { return e; }
+static inline Vector zero() { return 0; }
+static inline void store(double* p, Vector v) { *p = v; }
+static inline Vector multiplyAdd(Vector a, Vector b, Vector c) {
+	return a * b + c;
+}
+#endif
+
+/*
+   Pack buffers, one pair per thread so blocks
+   solved in parallel (see Rref::solveBlocks())
+   don't share them. They only ever grow.
+ */
+static thread_local std::vector<double> packedA;
+static thread_local std::vector<double> packedB;
+
+void Gemm::subtract(int m, int n, int k,
+		double* const* A, const int* acol,
+		double* const* B, int bcol,
+		double* const* C, int ccol) {
+	if (m <= 0 || n <= 0 || k <= 0) {
+		return;
+	}
+
+	int mp = (m + MR - 1) / MR * MR;
+	size_t sizeA = (size_t)mp * k;
+	size_t sizeB = (size_t)std::min(KC, k) * ((std::min(NC, n) + NR - 1) / NR * NR);
+
+	if (packedA.size() < sizeA) {
+		packedA.resize(sizeA);
+	}
+
+	if (packedB.size() < sizeB) {
+		packedB.resize(sizeB);
+	}
+
+	packA(m, k, A, acol, packedA.data());
+
+	for (int jc = 0; jc < n; jc += NC) {
+		int nc = std::min(NC, n - jc);
+
+		for (int pc = 0; pc < k; pc += KC) {
+			int kc = std::min(KC, k - pc);
+			const double* a = packedA.data() + (size_t)pc * mp;
+
+			packB(kc, nc, B + pc, bcol + jc, packedB.data());
+
+			for (int ic = 0; ic < m; ic += MC) {
+				int mc = std::min(MC, m - ic);
+
+				for (int jr = 0; jr < nc; jr += NR) {
+					const double* b = packedB.data() + (size_t)jr * kc;
+
+					for (int ir = ic; ir < ic + mc; ir += MR) {
+						kernel(kc, a + (size_t)ir * kc, b,
+								C + ir, ccol + jc + jr,
+								std::min(MR, m - ir), std::min(NR, nc - jr));
+					}
+				}
+			}
+		}
+	}
+}
+
+void Gemm::packA(int m, int k, double* const* A, const int* acol,
+		double* buffer) {
+	int mp = (m + MR - 1) / MR * MR;
+
+	for (int pc = 0; pc < k; pc += KC) {
+		int kc = std::min(KC, k - pc);
+		double* block = buffer + (size_t)pc * mp;
+
+		for (int ir = 0; ir < mp; ir += MR) {
+			double* out = block + (size_t)ir * kc;
+
+			for (int i = 0; i < MR; i++) {
+				if (ir + i >= m) {
+					for (int t = 0; t < kc; t++) {
+						out[t * MR + i] = 0;
+					}
+
+					continue;
+				}
+
+				const double* row = A[ir + i];
+
+				for (int t = 0; t < kc; t++) {
+					out[t * MR + i] = row[acol[pc + t]];
+				}
+			}
+		}
+	}
+}
+
+void Gemm::packB(int kc, int nc, double* const* B, int bcol,
+		double* buffer) {
+	int panels = (nc + NR - 1) / NR;
+
+	for (int p = 0; p < panels; p++) {
+		double* out = buffer + (size_t)p * NR * kc;
+		int nr = std::min(NR, nc - p * NR);
+
+		for (int t = 0; t < kc; t++) {
+			const double* row = B[t] + bcol + p * NR;
+			double* to = out + t * NR;
+
+			for (int j = 0; j < nr; j++) {
+				to[j] = row[j];
+			}
+
+			for (int j = nr; j < NR; j++) {
+				to[j] = 0;
+			}
+		}
+	}
+}
+
+void Gemm::kernel(int kc, const double* __restrict a,
+		const double* __restrict b,
+		double* const* C, int ccol, int mr, int nr) {
+	constexpr int V = NR / 2;
+	Vector c00 = zero(), c01 = zero();
+	Vector c10 = zero(), c11 = zero();
+	Vector c20 = zero(), c21 = zero();
+	Vector c30 = zero(), c31 = zero();
+
+	for (int t = 0; t < kc; t++) {
+		Vector b0 = load(b);
+		Vector b1 = load(b + V);
+		Vector e;
+
+		e = broadcast(a[0]);
+		c00 = multiplyAdd(e, b0, c00);
+		c01 = multiplyAdd(e, b1, c01);
+		e = broadcast(a[1]);
+		c10 = multiplyAdd(e, b0, c10);
+		c11 = multiplyAdd(e, b1, c11);
+		e = broadcast(a[2]);
+		c20 = multiplyAdd(e, b0, c20);
+		c21 = multiplyAdd(e, b1, c21);
+		e = broadcast(a[3]);
+		c30 = multiplyAdd(e, b0, c30);
+		c31 = multiplyAdd(e, b1, c31);
+
+		a += MR;
+		b += NR;
+	}
+
+	/*
+	   Padding of the packed panels is zero,
+	   so the full block was computed and only
+	   mr x nr of it is written back
+	 */
+	double acc[MR][NR];
+	store(acc[0], c00);
+	store(acc[0] + V, c01);
+	store(acc[1], c10);
+	store(acc[1] + V, c11);
+	store(acc[2], c20);
+	store(acc[2] + V, c21);
+	store(acc[3], c30);
+	store(acc[3] + V, c31);
+
+	for (int i = 0; i < mr; i++) {
+		double* c = C[i] + ccol;
+
+		for (int j = 0; j < nr; j++) {
+			c[j] -= acc[i][j];
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef GEMM_H_
+#define GEMM_H_
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Gemm.h                                                                                       *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   Matrix multiply kernel used by the
+   blocked elimination in Rref.
+
+   subtract() computes C -= A * B, where the
+   rows of A, B and C are separate arrays, as in
+   std::vector<RowData>. A is packed once into
+   panels of MR rows, blocks of B into panels of
+   NR columns sized to stay in cache, and an
+   MR x NR block of C is kept in registers while
+   it is updated. The pack buffers belong to the
+   calling thread and are reused between calls.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class Gemm {
+
+	public:
+
+		/*
+		   C -= A * B
+
+		   Parameters:
+		   m, n, k-> C is m x n, A is m x k, B is k x n
+		   A-> m row pointers, column t of the
+		   block is column acol[t] of each row
+		   B-> k row pointers, the block starts
+		   at column bcol of each row
+		   C-> m row pointers, the block starts
+		   at column ccol of each row
+
+		   A is read in full before C is written,
+		   so it may overlap C.
+		 */
+		static void subtract(int m, int n, int k,
+				double* const* A, const int* acol,
+				double* const* B, int bcol,
+				double* const* C, int ccol);
+
+	private:
+
+		/*
+		   Register block of C: MR rows of two
+		   vectors, 8 accumulators (see Gemm.cpp)
+		 */
+		static constexpr int MR = 4;
+#if defined(__AVX512F__)
+		static constexpr int NR = 16;
+#elif defined(__AVX__)
+		static constexpr int NR = 8;
+#elif defined(__SSE2__)
+		static constexpr int NR = 4;
+#else
+		static constexpr int NR = 2;
+#endif
+
+		/*
+		   Cache blocks. KC x NR numbers of B stay
+		   in L1 and MC x KC numbers of A in L2,
+		   while KC x NC numbers of B are packed
+		   at a time. MC is a multiple of MR.
+		 */
+		static constexpr int KC = 256;
+		static constexpr int MC = 128;
+		static constexpr int NC = 2048;
+
+		/*
+		   Packs A as k / KC blocks of m / MR
+		   panels of kc x MR numbers, zero padded
+		   to a multiple of MR rows
+		 */
+		static void packA(int m, int k, double* const* A, const int* acol,
+				double* buffer);
+
+		/*
+		   Packs a kc x nc block of B into buffer,
+		   as nc / NR panels of kc x NR numbers,
+		   zero padded to a multiple of NR
+		 */
+		static void packB(int kc, int nc, double* const* B, int bcol,
+				double* buffer);
+
+		/*
+		   C[0..mr) x [0..nr) -= a * b, where a is a
+		   packed panel of A and b one of B
+		 */
+		static void kernel(int kc, const double* a, const double* b,
+				double* const* C, int ccol, int mr, int nr);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include <cstring>
+
+#include "MatrixHash.h"
+
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static uint64_t rotl(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t mix(uint64_t acc, uint64_t input) {
+	acc += input * PRIME2;
+	acc = rotl(acc, 31);
+	return acc * PRIME1;
+}
+
+static uint64_t merge(uint64_t acc, uint64_t lane) {
+	acc ^= mix(0, lane);
+	return acc * PRIME1 + PRIME4;
+}
+
+MatrixHash::MatrixHash() {
+	lanes[0] = PRIME1 + PRIME2;
+	lanes[1] = PRIME2;
+	lanes[2] = 0;
+	lanes[3] = 0 - PRIME1;
+	count = 0;
+	H = 0;
+	W = 0;
+}
+
+void MatrixHash::update(const double* row, int W) {
+	for (int i = 0; i < W; i++) {
+		uint64_t bits;
+		memcpy(&bits, row + i, sizeof(bits));
+
+		lanes[count & 3] = mix(lanes[count & 3], bits);
+		count++;
+	}
+
+	this -> W = W;
+	H++;
+}
+
+uint64_t MatrixHash::digest() const {
+	uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7)
+			+ rotl(lanes[2], 12) + rotl(lanes[3], 18);
+
+	for (int i = 0; i < 4; i++) {
+		h = merge(h, lanes[i]);
+	}
+
+	/*
+	   Shape, so a 2x3 and a 3x2 matrix
+	   with the same numbers differ
+	 */
+	h += PRIME5 + count * 8;
+	h ^= mix(0, ((uint64_t)H << 32) | (uint32_t)W);
+	h = rotl(h, 27) * PRIME1 + PRIME4;
+
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+uint64_t MatrixHash::of(double** matrix, int W, int H) {
+	MatrixHash hash;
+
+	for (int i = 0; i < H; i++) {
+		hash.update(matrix[i], W);
+	}
+
+	return hash.digest();
+}
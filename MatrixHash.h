@@ -0,0 +1,77 @@
+#ifndef MATRIXHASH_H_
+#define MATRIXHASH_H_
+
+#include <cstdint>
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * MatrixHash.h                                                                                 *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   A 64 bit hash of the shape and the
+   numbers of a matrix, built one row at
+   a time so it can be computed while
+   the matrix is parsed.
+
+   Numbers are mixed into four independent
+   lanes with the xxHash64 round and merged
+   with its avalanche step. It is meant for
+   finding repeated matrices (see RrefCache.h),
+   not for security.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class MatrixHash {
+
+	public:
+
+		MatrixHash();
+
+		/*
+		   Adds a row of width W.
+		   All rows should have the same width
+		 */
+		void update(const double* row, int W);
+
+		/*
+		   Hash of the rows added so far,
+		   including their amount and width
+		 */
+		uint64_t digest() const;
+
+		/*
+		   Hash of a whole matrix
+		 */
+		static uint64_t of(double** matrix, int W, int H);
+
+	private:
+
+		uint64_t lanes[4];
+
+		/*
+		   Amount of numbers added
+		 */
+		uint64_t count;
+
+		int H;
+		int W;
+};
+
+#endif
@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "MatrixReader.h"
+
+MatrixReader::MatrixReader(std::string url, Format format) {
+	if (url == "-") {
+		in = stdin;
+		owned = false;
+	} else {
+		in = fopen(url.c_str(), format == BINARY ? "rb" : "r");
+		owned = true;
+
+		if (!in) {
+			throw std::ifstream::failure(
+					"\nrref::MatrixReader::MatrixReader("
+					"std::string,Format)->"
+					"can't open " + url + "\n");
+		}
+	}
+
+	this -> format = format;
+	buffer.resize(BUFFER_SIZE);
+	pos = len = 0;
+	lineNumber = 0;
+	matrices = 0;
+	rowWidth = -1;
+	rowsLeft = 0;
+}
+
+MatrixReader::MatrixReader(FILE* in, Format format) {
+	if (!in) {
+		throw std::invalid_argument(
+				"\nrref::MatrixReader::MatrixReader("
+				"FILE*,Format)->"
+				"null stream\n");
+	}
+
+	this -> in = in;
+	owned = false;
+	this -> format = format;
+	buffer.resize(BUFFER_SIZE);
+	pos = len = 0;
+	lineNumber = 0;
+	matrices = 0;
+	rowWidth = -1;
+	rowsLeft = 0;
+}
+
+MatrixReader::~MatrixReader() {
+	if (owned) {
+		fclose(in);
+	}
+}
+
+bool MatrixReader::next(std::vector<RowData>& rows) {
+	rows.clear();
+	hasher = MatrixHash();
+
+	bool found = format == BINARY
+			? nextBinary(rows)
+			: nextText(rows);
+
+	if (found) {
+		matrices++;
+	}
+
+	return found;
+}
+
+bool MatrixReader::nextRow(std::vector<double>& row) {
+	return format == BINARY
+			? nextBinaryRow(row)
+			: nextTextRow(row);
+}
+
+long MatrixReader::count() {
+	return matrices;
+}
+
+uint64_t MatrixReader::hash() {
+	return hasher.digest();
+}
+
+bool MatrixReader::fill() {
+	pos = 0;
+	len = fread(buffer.data(), 1, buffer.size(), in);
+
+	if (len == 0 && ferror(in)) {
+		throw std::ifstream::failure(
+				"\nrref::MatrixReader::fill()->"
+				"read error\n");
+	}
+
+	return len > 0;
+}
+
+bool MatrixReader::readLine(const char*& begin, const char*& end) {
+	carry.clear();
+
+	while (true) {
+		if (pos == len && !fill()) {
+
+			/*
+			   Last line of the stream
+			   had no terminator
+			 */
+			if (carry.empty()) {
+				return false;
+			}
+
+			begin = carry.data();
+			end = begin + carry.size();
+			lineNumber++;
+			return true;
+		}
+
+		const char* start = buffer.data() + pos;
+		const char* newline = (const char*)memchr(
+				start, '\n', len - pos);
+
+		if (newline) {
+			pos = newline - buffer.data() + 1;
+			lineNumber++;
+
+			/*
+			   Common case, the whole line is
+			   in buffer and nothing is copied
+			 */
+			if (carry.empty()) {
+				begin = start;
+				end = newline;
+			} else {
+				carry.append(start, newline - start);
+				begin = carry.data();
+				end = begin + carry.size();
+			}
+
+			return true;
+		}
+
+		carry.append(start, buffer.data() + len - start);
+		pos = len;
+	}
+}
+
+size_t MatrixReader::readBytes(void* dst, size_t n) {
+	char* out = (char*)dst;
+	size_t copied = 0;
+
+	while (copied < n) {
+		if (pos == len && !fill()) {
+			break;
+		}
+
+		size_t chunk = std::min(n - copied, len - pos);
+		memcpy(out + copied, buffer.data() + pos, chunk);
+		pos += chunk;
+		copied += chunk;
+	}
+
+	return copied;
+}
+
+int MatrixReader::parseLine(const char* begin, const char* end,
+		double* row, int W) {
+	int count = 0;
+	const char* p = begin;
+
+	while (true) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+			p++;
+		}
+
+		if (p == end) {
+			break;
+		}
+
+		/*
+		   from_chars doesn't accept a leading '+'
+		 */
+		if (*p == '+') {
+			p++;
+		}
+
+		double value;
+		auto result = std::from_chars(p, end, value);
+
+		if (result.ec != std::errc()
+				|| (result.ptr < end && *result.ptr != ' '
+				&& *result.ptr != '\t' && *result.ptr != '\r')) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::next()->"
+					"bad number on line "
+					+ std::to_string(lineNumber) + "\n");
+		}
+
+		if (!row) {
+			firstRow.push_back(value);
+		} else if (count < W) {
+			row[count] = value;
+		}
+
+		count++;
+		p = result.ptr;
+	}
+
+	return count;
+}
+
+bool MatrixReader::nextText(std::vector<RowData>& rows) {
+	const char* begin;
+	const char* end;
+	int W = -1;
+
+	while (readLine(begin, end)) {
+
+		/*
+		   The width of a matrix is
+		   set by its first row
+		 */
+		if (W == -1) {
+			firstRow.clear();
+
+			if ((W = parseLine(begin, end, nullptr, 0)) == 0) {
+
+				/*
+				   Blank lines between matrices
+				 */
+				W = -1;
+				continue;
+			}
+
+			rows.emplace_back(firstRow.data(), W);
+			hasher.update(firstRow.data(), W);
+			continue;
+		}
+
+		RowData row(W);
+		int count = parseLine(begin, end, row.data, W);
+
+		/*
+		   A blank line ends the matrix
+		 */
+		if (count == 0) {
+			break;
+		}
+
+		if (count != W) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::next()->"
+					"One row isn't proper length on line "
+					+ std::to_string(lineNumber) + "\n");
+		}
+
+		row.setRowInfo();
+		hasher.update(row.data, W);
+		rows.push_back(std::move(row));
+	}
+
+	return !rows.empty();
+}
+
+bool MatrixReader::nextBinary(std::vector<RowData>& rows) {
+	int32_t shape[2];
+	size_t n = readBytes(shape, sizeof(shape));
+
+	if (n == 0) {
+		return false;
+	}
+
+	if (n != sizeof(shape)) {
+		throw std::invalid_argument(
+				"\nrref::MatrixReader::next()->"
+				"truncated frame header\n");
+	}
+
+	int H = shape[0];
+	int W = shape[1];
+
+	if (H <= 0 || W <= 0) {
+		throw std::invalid_argument(
+				"\nrref::MatrixReader::next()->"
+				"invalid size\n");
+	}
+
+	rows.reserve(H);
+
+	for (int i = 0; i < H; i++) {
+		RowData row(W);
+
+		if (readBytes(row.data, W * sizeof(double))
+				!= W * sizeof(double)) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::next()->"
+					"truncated frame\n");
+		}
+
+		row.setRowInfo();
+		hasher.update(row.data, W);
+		rows.push_back(std::move(row));
+	}
+
+	return true;
+}
+
+bool MatrixReader::nextTextRow(std::vector<double>& row) {
+	const char* begin;
+	const char* end;
+
+	while (readLine(begin, end)) {
+		firstRow.clear();
+		int count = parseLine(begin, end, nullptr, 0);
+
+		if (count == 0) {
+
+			/*
+			   Blank lines between matrices
+			 */
+			if (rowWidth == -1) {
+				continue;
+			}
+
+			rowWidth = -1;
+			return false;
+		}
+
+		if (rowWidth == -1) {
+			rowWidth = count;
+			hasher = MatrixHash();
+			matrices++;
+		} else if (count != rowWidth) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::nextRow()->"
+					"One row isn't proper length on line "
+					+ std::to_string(lineNumber) + "\n");
+		}
+
+		hasher.update(firstRow.data(), count);
+		row.swap(firstRow);
+
+		return true;
+	}
+
+	rowWidth = -1;
+	return false;
+}
+
+bool MatrixReader::nextBinaryRow(std::vector<double>& row) {
+	if (rowsLeft == 0) {
+
+		/*
+		   Last row of the frame was read
+		 */
+		if (rowWidth != -1) {
+			rowWidth = -1;
+			return false;
+		}
+
+		int32_t shape[2];
+		size_t n = readBytes(shape, sizeof(shape));
+
+		if (n == 0) {
+			return false;
+		}
+
+		if (n != sizeof(shape)) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::nextRow()->"
+					"truncated frame header\n");
+		}
+
+		if (shape[0] <= 0 || shape[1] <= 0) {
+			throw std::invalid_argument(
+					"\nrref::MatrixReader::nextRow()->"
+					"invalid size\n");
+		}
+
+		rowsLeft = shape[0];
+		rowWidth = shape[1];
+		hasher = MatrixHash();
+		matrices++;
+	}
+
+	row.resize(rowWidth);
+
+	if (readBytes(row.data(), rowWidth * sizeof(double))
+			!= rowWidth * sizeof(double)) {
+		throw std::invalid_argument(
+				"\nrref::MatrixReader::nextRow()->"
+				"truncated frame\n");
+	}
+
+	hasher.update(row.data(), rowWidth);
+	rowsLeft--;
+
+	return true;
+}
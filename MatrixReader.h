@@ -0,0 +1,232 @@
+#ifndef MATRIXREADER_H_
+#define MATRIXREADER_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MatrixHash.h"
+#include "RowData.h"
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * MatrixReader.h                                                                               *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   This class reads a stream of matrices stored
+   back to back in one file, or arriving on stdin.
+
+   Two formats are supported:
+
+           -TEXT: rows of numbers separated by 1+ spaces
+           or tabs, as in Rref(std::string). Matrices are
+           separated by one or more blank lines.
+
+           -BINARY: each matrix is a frame made of a
+           32 bit int H, a 32 bit int W (native byte order),
+           followed by H * W doubles in row major order.
+
+   Each call to next() returns the rows of one
+   matrix, parsed straight into RowData objects,
+   so they can be moved into Rref(std::vector<RowData>&&)
+   without copying the data again. A MatrixHash
+   of each matrix is computed while it is parsed
+   (see RrefCache.h).
+
+   Input is read in large blocks, so the reader
+   is not limited by per line stream overhead.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class MatrixReader {
+
+	public:
+
+		enum Format { TEXT, BINARY };
+
+		/*
+		   Opens a matrix stream.
+
+		   Parameters:
+		   url-> name of file, or "-" for stdin
+		   format-> TEXT or BINARY
+
+		   Throws:
+		   std::ifstream::failure-> file can't be opened
+		 */
+		MatrixReader(std::string url, Format format = TEXT);
+
+		/*
+		   Reads from an already open stream.
+		   The stream is not closed by the reader.
+		 */
+		MatrixReader(FILE* in, Format format = TEXT);
+
+		MatrixReader(const MatrixReader& other) = delete;
+		MatrixReader& operator=(const MatrixReader& other) = delete;
+
+		/*
+		   Closes the file if it was
+		   opened by the reader
+		 */
+		~MatrixReader();
+
+		/*
+		   Reads the next matrix.
+
+		   Parameters:
+		   rows-> cleared, then filled with the rows
+		   of the next matrix
+
+		   Returns:
+		   true-> a matrix was read
+		   false-> end of stream
+
+		   Throws:
+		   std::invalid_argument-> bad number, rows of
+		   inconsistent length, or truncated frame
+		   std::ifstream::failure-> read error
+		 */
+		bool next(std::vector<RowData>& rows);
+
+		/*
+		   Reads the next matrix one row at a time,
+		   for matrices too large to keep in memory
+		   (see RrefSketch.h). Don't mix with next()
+		   within one matrix.
+
+		   Parameters:
+		   row-> set to the numbers of the next row
+
+		   Returns:
+		   true-> a row was read
+		   false-> the matrix has no rows left. The
+		   next call starts on the next matrix. A
+		   matrix without rows means end of stream.
+
+		   Throws:
+		   see MatrixReader::next()
+		 */
+		bool nextRow(std::vector<double>& row);
+
+		/*
+		   Number of matrices returned by next()
+		 */
+		long count();
+
+		/*
+		   MatrixHash of the matrix last
+		   returned by next(), or of the rows
+		   of the current matrix read by nextRow()
+		 */
+		uint64_t hash();
+
+	private:
+
+		/*
+		   Size of the block read from
+		   the stream at a time
+		 */
+		static const size_t BUFFER_SIZE = 1 << 20;
+
+		FILE* in;
+
+		/*
+		   True if in was opened by the
+		   reader and must be closed
+		 */
+		bool owned;
+
+		Format format;
+
+		/*
+		   Block read from the stream.
+		   pos is the next unread byte,
+		   len the number of valid bytes.
+		 */
+		std::vector<char> buffer;
+		size_t pos;
+		size_t len;
+
+		/*
+		   Holds a line that crosses the
+		   end of buffer
+		 */
+		std::string carry;
+
+		/*
+		   Numbers of the row whose width
+		   is not yet known
+		 */
+		std::vector<double> firstRow;
+
+		/*
+		   State of nextRow(). Width of the matrix
+		   being read, -1 between matrices, and rows
+		   left in the current binary frame.
+		 */
+		int rowWidth;
+		int rowsLeft;
+
+		long lineNumber;
+		long matrices;
+
+		MatrixHash hasher;
+
+		/*
+		   Reads the next block into buffer.
+		   Returns false at end of stream.
+		 */
+		bool fill();
+
+		/*
+		   Sets [begin, end) to the next line,
+		   without the line terminator.
+		   The range stays valid until the
+		   next call. Returns false at end of stream.
+		 */
+		bool readLine(const char*& begin, const char*& end);
+
+		/*
+		   Copies n bytes into dst.
+		   Returns the number of bytes copied,
+		   which is less than n at end of stream.
+		 */
+		size_t readBytes(void* dst, size_t n);
+
+		bool nextText(std::vector<RowData>& rows);
+		bool nextBinary(std::vector<RowData>& rows);
+		bool nextTextRow(std::vector<double>& row);
+		bool nextBinaryRow(std::vector<double>& row);
+
+		/*
+		   Parses one line of numbers.
+		   If row is nullptr, numbers are
+		   appended to firstRow, otherwise
+		   they are written into row, which
+		   has room for W numbers.
+
+		   Returns the amount of numbers on the line
+		 */
+		int parseLine(const char* begin, const char* end,
+				double* row, int W);
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "MatrixWriter.h"
+#include "Rref.h"
+
+MatrixWriter::MatrixWriter(int fd, int precision, double clamp) {
+	if (fd < 0) {
+		throw std::invalid_argument(
+				"\nrref::MatrixWriter::MatrixWriter("
+				"int,int,double)->"
+				"invalid file descriptor\n");
+	}
+
+	this -> fd = fd;
+	os = nullptr;
+	file = nullptr;
+	init(precision, clamp);
+}
+
+MatrixWriter::MatrixWriter(std::ostream& os, int precision, double clamp) {
+	fd = -1;
+	this -> os = &os;
+	file = nullptr;
+	init(precision, clamp);
+}
+
+MatrixWriter::MatrixWriter(FILE* file, int precision, double clamp) {
+	if (!file) {
+		throw std::invalid_argument(
+				"\nrref::MatrixWriter::MatrixWriter("
+				"FILE*,int,double)->"
+				"null file\n");
+	}
+
+	fd = -1;
+	os = nullptr;
+	this -> file = file;
+	init(precision, clamp);
+}
+
+MatrixWriter::~MatrixWriter() {
+	try {
+		flush();
+	} catch (...) {}
+}
+
+void MatrixWriter::init(int precision, double clamp) {
+	if (precision < 0 || precision > 17) {
+		throw std::invalid_argument(
+				"\nrref::MatrixWriter::MatrixWriter()->"
+				"precision must be in [0, 17]\n");
+	}
+
+	if (!(clamp >= 0)) {
+		throw std::invalid_argument(
+				"\nrref::MatrixWriter::MatrixWriter()->"
+				"clamp must be >= 0\n");
+	}
+
+	this -> precision = precision;
+	this -> clamp = clamp;
+	fixed = false;
+	padded = false;
+	matrices = 0;
+	buffer.resize(BUFFER_SIZE);
+	len = 0;
+}
+
+void MatrixWriter::setFixed(bool fixed) {
+	this -> fixed = fixed;
+}
+
+void MatrixWriter::setPadded(bool padded) {
+	this -> padded = padded;
+}
+
+void MatrixWriter::beginMatrix() {
+	if (matrices++ > 0) {
+		if (len == buffer.size()) {
+			flush();
+		}
+
+		buffer[len++] = '\n';
+	}
+}
+
+void MatrixWriter::write(const Rref& matrix) {
+	write(matrix.getRows());
+}
+
+void MatrixWriter::write(const std::vector<RowData>& rows) {
+	beginMatrix();
+
+	for (auto& row : rows) {
+		write(row.data, row.W);
+	}
+}
+
+void MatrixWriter::write(const RowData* rows, int H) {
+	beginMatrix();
+
+	for (int i = 0; i < H; i++) {
+		write(rows[i].data, rows[i].W);
+	}
+}
+
+void MatrixWriter::write(double** matrix, int W, int H) {
+	beginMatrix();
+
+	for (int i = 0; i < H; i++) {
+		write(matrix[i], W);
+	}
+}
+
+void MatrixWriter::write(const double* row, int W) {
+	std::chars_format format = fixed
+			? std::chars_format::fixed
+			: std::chars_format::general;
+
+	/*
+	   One byte is kept after each number
+	   for the padding space
+	 */
+	char* end = buffer.data() + buffer.size() - 1;
+
+	for (int i = 0; i < W; i++) {
+		if (buffer.size() - len < MAX_NUMBER) {
+			flush();
+		}
+
+		char* p = buffer.data() + len;
+
+		if (i > 0 || padded) {
+			*p++ = ' ';
+		}
+
+		/*
+		   Absolute value, so small negative
+		   numbers are clamped too. This also
+		   turns -0 into 0.
+		 */
+		double e = row[i];
+
+		if (std::fabs(e) < clamp || e == 0) {
+			e = 0;
+		}
+
+		auto result = std::to_chars(p, end, e, format, precision);
+
+		/*
+		   Huge numbers in fixed notation can be
+		   longer than MAX_NUMBER, so may not fit
+		   in what is left: retry in the empty
+		   buffer, and only fall back to scientific
+		   if they don't fit there either
+		 */
+		if (result.ec != std::errc()) {
+			len = p - buffer.data();
+			flush();
+			p = buffer.data();
+			result = std::to_chars(p, end, e, format, precision);
+
+			if (result.ec != std::errc()) {
+				result = std::to_chars(p, end,
+						e, std::chars_format::scientific, precision);
+			}
+		}
+
+		p = result.ptr;
+
+		if (padded) {
+			*p++ = ' ';
+		}
+
+		len = p - buffer.data();
+	}
+
+	if (buffer.size() - len < 2) {
+		flush();
+	}
+
+	buffer[len++] = '\n';
+
+	if (padded) {
+		buffer[len++] = '\n';
+	}
+}
+
+void MatrixWriter::flush() {
+	if (os) {
+		os -> write(buffer.data(), len);
+		len = 0;
+
+		if (!os -> flush()) {
+			throw std::ofstream::failure(
+					"\nrref::MatrixWriter::flush()->"
+					"write error\n");
+		}
+
+		return;
+	}
+
+	if (file) {
+		bool complete = fwrite(buffer.data(), 1, len, file) == len;
+		len = 0;
+
+		if (fflush(file) != 0 || !complete) {
+			throw std::ofstream::failure(
+					"\nrref::MatrixWriter::flush()->"
+					"write error\n");
+		}
+
+		return;
+	}
+
+	size_t written = 0;
+
+	while (written < len) {
+		ssize_t n = ::write(fd, buffer.data() + written, len - written);
+
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			len = 0;
+			throw std::ofstream::failure(
+					"\nrref::MatrixWriter::flush()->"
+					"write error\n");
+		}
+
+		written += n;
+	}
+
+	len = 0;
+}
@@ -0,0 +1,185 @@
+#ifndef MATRIXWRITER_H_
+#define MATRIXWRITER_H_
+
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+#include "RowData.h"
+
+class Rref;
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * MatrixWriter.h                                                                               *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   Writes matrices as text, in the format
+   read by MatrixReader: numbers separated by
+   a space, one row per line, and a blank line
+   between matrices.
+
+   Numbers are formatted with std::to_chars into
+   a large buffer, which is written to a file
+   descriptor, FILE* or std::ostream only when
+   full or on flush(), instead of one printf
+   per number.
+
+   Numbers with an absolute value smaller than
+   the clamp are written as 0, so rounding noise
+   such as 1e-17 or -0 doesn't show up in results.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class MatrixWriter {
+
+	public:
+
+		/*
+		   Writes to a file descriptor, which
+		   is not closed by the writer.
+
+		   Parameters:
+		   fd-> file descriptor, e.g. STDOUT_FILENO
+		   precision-> significant digits, or digits after
+		   the decimal point if setFixed(true)
+		   clamp-> numbers with |e| < clamp are written as 0
+
+		   Throws:
+		   std::invalid_argument-> fd < 0, precision
+		   not in [0, 17], or clamp < 0
+		 */
+		MatrixWriter(int fd, int precision = 6, double clamp = 1E-9);
+
+		/*
+		   Writes to os. See MatrixWriter(int, int, double)
+		 */
+		MatrixWriter(std::ostream& os, int precision = 6,
+				double clamp = 1E-9);
+
+		/*
+		   Writes to file with fwrite(), e.g. a
+		   stream without a file descriptor. The
+		   file is not closed by the writer.
+		   See MatrixWriter(int, int, double)
+
+		   Throws:
+		   std::invalid_argument-> file is nullptr
+		 */
+		MatrixWriter(FILE* file, int precision = 6,
+				double clamp = 1E-9);
+
+		MatrixWriter(const MatrixWriter& other) = delete;
+		MatrixWriter& operator=(const MatrixWriter& other) = delete;
+
+		/*
+		   Flushes what is left in the buffer.
+		   Errors are ignored, call flush()
+		   before to detect them.
+		 */
+		~MatrixWriter();
+
+		/*
+		   true-> fixed notation, like %.2f
+		   false-> shortest of fixed and scientific
+		   notation, like %g (default)
+		 */
+		void setFixed(bool fixed);
+
+		/*
+		   true-> a space on both sides of each
+		   number and a blank line after each row,
+		   the layout of Rref::printMatrix(). Such
+		   output can't be read back by MatrixReader.
+		   false-> one space between numbers and
+		   one row per line (default)
+		 */
+		void setPadded(bool padded);
+
+		/*
+		   Writes a matrix, preceded by a blank
+		   line if it isn't the first one written.
+
+		   Throws:
+		   std::ofstream::failure-> write error
+		 */
+		void write(const Rref& matrix);
+		void write(const std::vector<RowData>& rows);
+		void write(double** matrix, int W, int H);
+
+		/*
+		   Writes H consecutive rows as one matrix,
+		   e.g. only the nonzero rows of an Rref
+		 */
+		void write(const RowData* rows, int H);
+
+		/*
+		   Writes one row followed by a newline
+		 */
+		void write(const double* row, int W);
+
+		/*
+		   Writes the buffer to the output
+
+		   Throws:
+		   std::ofstream::failure-> write error
+		 */
+		void flush();
+
+	private:
+
+		static const size_t BUFFER_SIZE = 1 << 20;
+
+		/*
+		   Room kept at the end of buffer for
+		   one number and its separator
+		 */
+		static const size_t MAX_NUMBER = 64;
+
+		/*
+		   -1 if writing to os or file
+		 */
+		int fd;
+		std::ostream* os;
+		FILE* file;
+
+		int precision;
+		double clamp;
+		bool fixed;
+		bool padded;
+
+		/*
+		   Amount of matrices written, used
+		   to separate them with blank lines
+		 */
+		long matrices;
+
+		std::vector<char> buffer;
+		size_t len;
+
+		void init(int precision, double clamp);
+
+		/*
+		   Starts a new matrix block
+		 */
+		void beginMatrix();
+};
+
+#endif
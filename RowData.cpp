@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <stdexcept>
@@ -51,6 +52,19 @@ RowData::RowData(double* row, int W) {
 	setRowInfo();
 }
 
+RowData::RowData(int W) {
+	if (W <= 0) {
+		throw std::invalid_argument(
+				"\nrref::rowData::rowData(int)->"
+				"empty row");
+	}
+
+	this -> W = W;
+	data = new double[W]();
+	zeroRow = true;
+	pivotIndex = -1;
+}
+
 RowData::RowData(const RowData& other) {
 	W = other.W;
 	data = new double[W];
@@ -73,9 +87,11 @@ RowData::~RowData() {
 	}
 }
 
-void RowData::setRowInfo() {
+void RowData::setRowInfo(double tolerance) {
 	for (int i = 0; i < W; i++) {
-		if (data[i] != 0 || i == W - 1) {
+		bool zero = std::fabs(data[i]) <= tolerance;
+
+		if (!zero || i == W - 1) {
 
 			/*
 			 * We searched the whole row,
@@ -85,7 +101,7 @@ void RowData::setRowInfo() {
 			 * if user wishes to evaluate if a
 			 * RowData is a zeroRow based on pivot index
 			 */
-			if (data[i] == 0) {
+			if (zero) {
 				zeroRow = true;
 				pivotIndex = -1;
 			} else {
@@ -93,6 +109,7 @@ void RowData::setRowInfo() {
 				/*
 				 * nonzero found, we found the pivot
 				 */
+				zeroRow = false;
 				pivotIndex = i;
 			}
 
@@ -101,9 +118,9 @@ void RowData::setRowInfo() {
 	}
 }
 
-void RowData::print() {
+void RowData::print(FILE* out) {
 	for(auto& e : *this){
-		printf(" %.2f ",e < 1E-3 ? 0 : e);
+		fprintf(out, " %.2f ",std::fabs(e) < 1E-3 ? 0 : e);
 	}
 }
 
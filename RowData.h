@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -113,6 +114,21 @@ class RowData{
 		 */
 		RowData(double* row, int W);
 
+		/*
+		   Constructs a row of W zeros.
+
+		   Meant for readers that parse
+		   numbers straight into data,
+		   avoiding a temporary copy.
+		   Call setRowInfo() once data
+		   is filled in.
+
+		   Throws:
+
+		   std::invalid_argument-> W <= 0
+		 */
+		explicit RowData(int W);
+
 		/*
 		   Also makes a copy of double* data
 		 */
@@ -136,13 +152,17 @@ class RowData{
 		   the row is modified.
 		   It is recommended you call this after
 		   calling elementaryAdd(RowData&,double)
+
+		   Parameters:
+		   tolerance-> entries with a magnitude
+		   <= tolerance count as zero
 		 */
-		void setRowInfo();
+		void setRowInfo(double tolerance = 0);
 
 		/*
-		   Prints row
+		   Prints row to out
 		 */
-		void print();
+		void print(FILE* out = stdout);
 
 		RowData& operator=(const RowData& other);
 
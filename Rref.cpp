@@ -1,12 +1,29 @@
 #include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
 #include <cstdio>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 
+#include "Gemm.h"
+#include "MatrixHash.h"
+#include "MatrixWriter.h"
 #include "Rref.h"
 
-Rref::Rref(std::string url) {
+Rref::Rref(std::string url, Pivoting pivoting, int preprocess)
+		: Rref(parse(url), pivoting, preprocess) {}
+
+std::vector<RowData> Rref::parse(std::string url, uint64_t* hash) {
+	std::vector<RowData> rows;
+	MatrixHash hasher;
+
 	std::ifstream ifs;
 	ifs.exceptions(std::ifstream::failbit
 			| std::ifstream::badbit);
@@ -17,7 +34,7 @@ Rref::Rref(std::string url) {
 		std::string buf;
 		std::regex r("[ ]+");
 
-		W  = -1;
+		int W  = -1;
 
 		while (!ifs.eof()) {
 			std::getline(ifs, buf);
@@ -31,17 +48,22 @@ Rref::Rref(std::string url) {
 			}
 
 			rows.push_back(RowData{tokens, W});
+
+			/*
+			   Hash while the row is
+			   still in cache
+			 */
+			if (hash) {
+				hasher.update(rows.back().data, W);
+			}
 		}
 
 		ifs.close();
 
-		if ((H = rows.size()) == 0) {
+		if (rows.size() == 0) {
 			throw std::ifstream::failure("No data");
 		}
 
-		setRowInfo();
-		solve();
-
 	} catch(std::ifstream::failure& e) {
 		if (ifs.is_open()) {
 			ifs.close();
@@ -53,9 +75,16 @@ Rref::Rref(std::string url) {
 
 		throw std::ifstream::failure(msg);
 	}
+
+	if (hash) {
+		*hash = hasher.digest();
+	}
+
+	return rows;
 }
 
-Rref::Rref(double** matrix, int W, int H) {
+Rref::Rref(double** matrix, int W, int H, Pivoting pivoting,
+		int preprocess) {
 	if (!matrix) {
 		throw std::invalid_argument(
 				"\nrref::rref(double**, int, int)->"
@@ -70,14 +99,75 @@ Rref::Rref(double** matrix, int W, int H) {
 
 	this -> W = W;
 	this -> H = H;
+	this -> pivoting = pivoting;
+	this -> preprocess = preprocess;
 
 	for (int i = 0; i < H; i++) {
 		rows.push_back(
 				RowData(matrix[i], W));
 	}
 
+	solve();
+}
+
+Rref::Rref(std::vector<RowData>&& rows, Pivoting pivoting,
+		int preprocess) {
+	if (rows.empty()) {
+		throw std::invalid_argument(
+				"\nrref::rref(std::vector<RowData>&&)->"
+				"empty matrix\n");
+	}
+
+	W = rows[0].W;
+	H = rows.size();
+
+	for (auto& e : rows) {
+		if (e.W != W) {
+			throw std::invalid_argument(
+					"\nrref::rref(std::vector<RowData>&&)->"
+					"One row isn't proper length\n");
+		}
+	}
+
+	this -> rows = std::move(rows);
+	this -> pivoting = pivoting;
+	this -> preprocess = preprocess;
+
+	solve();
+}
+
+Rref::Rref(std::vector<RowData>&& rows, const Rref& parent) {
+	W = rows[0].W;
+	H = rows.size();
+
+	this -> rows = std::move(rows);
+	pivoting = PARTIAL;
+	preprocess = NONE;
+	tolerance = parent.tolerance;
+	reduced = H;
+
+	reduce();
+
+	firstNonZeroRow = 0;
 	setRowInfo();
-    solve();
+}
+
+Rref::Rref(double* const* matrix, int N) {
+	W = N;
+	H = N;
+	firstNonZeroRow = 0;
+	zeroMatrix = false;
+	pivoting = PARTIAL;
+	preprocess = NONE;
+	reduced = N;
+	structure = GENERAL;
+
+	for (int i = 0; i < N; i++) {
+		rows.push_back(RowData(matrix[i], N));
+	}
+
+	setTolerance();
+	spread.assign(W, 0);
 }
 
 Rref::Rref(const Rref& other) {
@@ -86,6 +176,11 @@ Rref::Rref(const Rref& other) {
 	rows = other.rows;
 	firstNonZeroRow = other.firstNonZeroRow;
 	zeroMatrix = other.zeroMatrix;
+	pivoting = other.pivoting;
+	preprocess = other.preprocess;
+	tolerance = other.tolerance;
+	reduced = other.reduced;
+	structure = other.structure;
 }
 
 Rref::Rref(Rref&& other) noexcept{
@@ -94,6 +189,11 @@ Rref::Rref(Rref&& other) noexcept{
 	rows = std::move(other.rows);
 	firstNonZeroRow = other.firstNonZeroRow;
 	zeroMatrix = other.zeroMatrix;
+	pivoting = other.pivoting;
+	preprocess = other.preprocess;
+	tolerance = other.tolerance;
+	reduced = other.reduced;
+	structure = other.structure;
 }
 
 Rref::~Rref() {}
@@ -108,6 +208,11 @@ Rref& Rref::operator=(const Rref& other) {
 	rows = other.rows;
 	firstNonZeroRow = other.firstNonZeroRow;
 	zeroMatrix = other.zeroMatrix;
+	pivoting = other.pivoting;
+	preprocess = other.preprocess;
+	tolerance = other.tolerance;
+	reduced = other.reduced;
+	structure = other.structure;
 
 	return *this;
 }
@@ -118,11 +223,16 @@ Rref& Rref::operator=(Rref&& other) noexcept{
 	rows = std::move(other.rows);
 	firstNonZeroRow = other.firstNonZeroRow;
 	zeroMatrix = other.zeroMatrix;
+	pivoting = other.pivoting;
+	preprocess = other.preprocess;
+	tolerance = other.tolerance;
+	reduced = other.reduced;
+	structure = other.structure;
 
 	return *this;
 }
 
-double** Rref::getMatrix() {
+double** Rref::getMatrix() const {
 	double** data = new double*[H];
 
 	for (int i = 0; i < H; i++) {
@@ -134,131 +244,1480 @@ double** Rref::getMatrix() {
 	return data;
 }
 
-void Rref::printMatrix() {
-	for (auto& e : rows) {
-		e.print();
-		printf("\n\n");
+const std::vector<RowData>& Rref::getRows() const {
+	return rows;
+}
+
+int Rref::rank() const {
+	return zeroMatrix ? 0 : H - firstNonZeroRow;
+}
+
+double Rref::getTolerance() const {
+	return tolerance;
+}
+
+Rref::Structure Rref::getStructure() const {
+	return structure;
+}
+
+int Rref::pivotColumns(int* columns) const {
+	int r = 0;
+
+	for (int i = zeroMatrix ? H : firstNonZeroRow; i < H; i++) {
+		columns[r++] = rows[i].pivotIndex;
 	}
+
+	return r;
 }
 
-bool Rref::isRef() {
-	int prevPivot = -1;
+int Rref::freeColumns(int* columns) const {
+	int i = zeroMatrix ? H : firstNonZeroRow;
+	int f = 0;
 
-	for (int i = firstNonZeroRow; i < H; i++) {
-		if(i == firstNonZeroRow){
-			prevPivot = rows[i].pivotIndex;
+	for (int c = 0; c < W; c++) {
+		if (i < H && rows[i].pivotIndex == c) {
+			i++;
+			continue;
+		}
+
+		columns[f++] = c;
+	}
+
+	return f;
+}
+
+int Rref::nullspace(double* basis) const {
+	return nullBasis(basis, W);
+}
+
+int Rref::solution(double* particular, double* homogeneous) const {
+	int first = zeroMatrix ? H : firstNonZeroRow;
+
+	/*
+	   Rows are sorted by pivot, so only
+	   the last one can have it in b
+	 */
+	if (first < H && rows[H - 1].pivotIndex == W - 1) {
+		return -1;
+	}
+
+	std::fill(particular, particular + W - 1, 0);
+
+	for (int i = first; i < H; i++) {
+		particular[rows[i].pivotIndex] = rows[i].data[W - 1];
+	}
+
+	if (!homogeneous) {
+		return W - 1 - rank();
+	}
+
+	return nullBasis(homogeneous, W - 1);
+}
+
+int Rref::nullBasis(double* basis, int width) const {
+	int first = zeroMatrix ? H : firstNonZeroRow;
+	int i = first;
+	int n = 0;
+
+	for (int c = 0; c < width; c++) {
+		if (i < H && rows[i].pivotIndex == c) {
+			i++;
 			continue;
 		}
 
+		double* v = basis + (size_t)n * width;
+		std::fill(v, v + width, 0);
+		v[c] = 1;
+
 		/*
-		   In ref, the pivot of the previous row
-		   needs to be of a smaller index than the
-		   current row
+		   Rows with a pivot right of c
+		   are 0 in column c
 		 */
-		if ((rows[i].pivotIndex <= prevPivot)) {
-			return false;
+		for (int r = first; r < i; r++) {
+			v[rows[r].pivotIndex] = -rows[r].data[c];
 		}
 
-		prevPivot = rows[i].pivotIndex;
+		n++;
 	}
 
-	return true;
+	return n;
 }
 
-void Rref::solve() {
-	while (true) {
-		if (zeroMatrix) {
-			break;
+double** Rref::inverse(double** matrix, int N, double* determinant) {
+	if (!matrix) {
+		throw std::invalid_argument(
+				"\nrref::inverse(double**, int, double*)->"
+				"null matrix\n");
+	}
+
+	if (N <= 0) {
+		throw std::invalid_argument(
+				"\nrref::inverse(double**, int, double*)->"
+				"invalid size\n");
+	}
+
+	Rref a(matrix, N);
+	std::vector<int> swaps(N);
+	double mantissa = 1;
+	int exponent = 0;
+
+	for (int k = 0; k < N; k++) {
+		int p = a.pivotRow(k, k);
+
+		if (std::fabs(a.rows[p][k]) <= a.threshold(k)) {
+			throw std::invalid_argument(
+					"\nrref::inverse(double**, int, double*)->"
+					"singular matrix\n");
 		}
 
-		if (!isRef()) {
-			doAnRefPass();
-		} else {
-			toRref();
-			break;
+		std::swap(a.rows[k].data, a.rows[p].data);
+		swaps[k] = p;
+
+		if (p != k) {
+			mantissa = -mantissa;
 		}
 
+		int e;
+		mantissa = std::frexp(mantissa * a.rows[k][k], &e);
+		exponent += e;
+
 		/*
-		   Update each RowInfo in Rref::rows
-		   to allow for processing in
-		   future calls to isRef(), doAnRefPass, and
-		   toRref()
+		   Starting at column 0, column k of the
+		   identity takes the place of the pivot:
+		   it becomes 1 / pivot
 		 */
-		setRowInfo();
+		a.eliminate(k, k, 0, 0);
+	}
+
+	/*
+	   (PA)^-1 = A^-1 * P^-1, so the row
+	   swaps come back as column swaps
+	 */
+	for (int k = N - 1; k >= 0; k--) {
+		if (swaps[k] == k) {
+			continue;
+		}
+
+		for (auto& row : a.rows) {
+			std::swap(row[k], row[swaps[k]]);
+		}
+	}
+
+	if (determinant) {
+		*determinant = std::ldexp(mantissa, exponent);
 	}
+
+	return a.getMatrix();
 }
 
-void Rref::setRowInfo() {
-	for (int i = firstNonZeroRow; i < H; i++) {
-		rows[i].setRowInfo();
+double Rref::determinant(double** matrix, int N, bool* singular) {
+	if (!matrix) {
+		throw std::invalid_argument(
+				"\nrref::determinant(double**, int, bool*)->"
+				"null matrix\n");
 	}
 
-	/*
-	   Moves all zero rows to the top
-	   of the matrix Rref::rows so we can
-	   ignore them.
+	if (N <= 0) {
+		throw std::invalid_argument(
+				"\nrref::determinant(double**, int, bool*)->"
+				"invalid size\n");
+	}
 
-	   Puts matrix in hair-step form,
-	   or attempts to do so.
-	 */
-	std::sort(rows.begin(), rows.end());
+	Rref a(matrix, N);
+	double mantissa = 1;
+	int exponent = 0;
 
+	if (singular) {
+		*singular = false;
+	}
 
-	int i = 0;
-	for ( ; i < H; i++) {
-		if (rows[i]) {
-			firstNonZeroRow = i;
-			break;
+	for (int k = 0; k < N; k++) {
+		int p = a.pivotRow(k, k);
+		double pivot = a.rows[p][k];
+
+		if (pivot == 0) {
+			if (singular) {
+				*singular = true;
+			}
+
+			return 0;
+		}
+
+		/*
+		   A pivot that is only rounding noise
+		   is still used, the value stays the
+		   determinant of the stored matrix
+		 */
+		if (singular && std::fabs(pivot) <= a.threshold(k)) {
+			*singular = true;
+		}
+
+		if (p != k) {
+			std::swap(a.rows[k].data, a.rows[p].data);
+			mantissa = -mantissa;
 		}
+
+		int e;
+		mantissa = std::frexp(mantissa * pivot, &e);
+		exponent += e;
+
+		a.eliminate(k, k, k + 1, k + 1);
 	}
 
-	zeroMatrix = (i == H);
+	return std::ldexp(mantissa, exponent);
+}
+
+void Rref::printMatrix(FILE* out) const {
+	MatrixWriter writer(out, 2, 1E-3);
+	writer.setFixed(true);
+	writer.setPadded(true);
+	writer.write(*this);
+	writer.flush();
 }
 
+void Rref::solve() {
+	reduced = H;
+	setTolerance();
+
+	if (preprocess & DEDUPLICATE) {
+		deduplicate();
+	}
+
+	std::vector<double> columnScale;
+
+	if (preprocess & EQUILIBRATE) {
+		equilibrate(columnScale);
+		setTolerance();
+	}
+
+	if (preprocess & TOURNAMENT) {
+		tournament();
+	}
+
+	if (pivoting != PARTIAL) {
+		reduceRowSpace();
+	}
+
+	reduce();
+
+	/*
+	   Sets pivots and moves zero rows
+	   to the top, as callers expect
+	 */
+	firstNonZeroRow = 0;
+	setRowInfo();
+
+	if (!columnScale.empty() && !zeroMatrix) {
+		unscale(columnScale);
+	}
+}
+
+void Rref::reduce() {
+	Profile profile;
+	structure = pivoting == PARTIAL ? analyze(profile) : GENERAL;
+
+	if (structure == GENERAL) {
+		if (std::min(reduced, W) >= BLOCKED_MIN) {
+			blockedGaussJordan();
+		} else {
+			gaussJordan();
+		}
+
+		return;
+	}
 
-void Rref::doAnRefPass() {
-	for (int i = H - 1; i > firstNonZeroRow; i--) {
-		int pivot1 = rows[i].pivotIndex;
+	if (structure == BLOCK_DIAGONAL) {
+		solveBlocks(profile);
+	} else {
+		std::vector<int> pivots;
+
+		if (structure == ECHELON) {
+			pivots = profile.first;
+		} else {
+			bandedEchelon(profile, pivots);
+		}
 
 		/*
-		   We only want to do a row operation
-		   if pivot of previous row is in
-		   same place as current row
+		   A dense triangle is better
+		   done with matrix multiplies
 		 */
-		if (pivot1 == rows[i-1].pivotIndex) {
+		if (structure == ECHELON && (int)pivots.size() >= BLOCKED_MIN
+				&& profile.upper * 4 > W) {
+			backSubstitute(profile.a, pivots);
+		} else {
+			bandedBackSubstitute(profile, pivots);
+		}
+	}
 
-			/*
-			   row addition. see RowData::elementaryAdd
-			 */
-			rows[i].elementaryAdd(rows[i - 1], pivot1);
+	for (int i = 0; i < reduced; i++) {
+		rows[i].data = profile.a[i];
+	}
+}
+
+Rref::Structure Rref::analyze(Profile& profile) {
+	std::vector<double*> zeros;
+
+	for (int i = 0; i < reduced; i++) {
+		double* row = rows[i].data;
+		int first = 0;
+
+		while (first < W && std::fabs(row[first]) <= tolerance) {
+			row[first++] = 0;
+		}
+
+		if (first == W) {
+			zeros.push_back(row);
+			continue;
+		}
+
+		int last = W - 1;
+
+		while (std::fabs(row[last]) <= tolerance) {
+			row[last--] = 0;
+		}
+
+		profile.a.push_back(row);
+		profile.first.push_back(first);
+		profile.last.push_back(last);
+	}
+
+	int n = profile.a.size();
+	profile.nonzero = n;
+	profile.a.insert(profile.a.end(), zeros.begin(), zeros.end());
+
+	bool echelon = true;
+	bool sorted = true;
+	profile.lower = 0;
+	profile.upper = 0;
+
+	for (int i = 0; i < n; i++) {
+		if (i > 0) {
+			echelon = echelon && profile.first[i] > profile.first[i - 1];
+			sorted = sorted && profile.first[i] >= profile.first[i - 1];
 		}
+
+		profile.lower = std::max(profile.lower, i - profile.first[i]);
+		profile.upper = std::max(profile.upper,
+				profile.last[i] - profile.first[i]);
+	}
+
+	if (echelon) {
+		return ECHELON;
+	}
+
+	if (sorted && (profile.lower + profile.upper + 1) * 4 <= W) {
+		return BANDED;
+	}
+
+	if (findBlocks(profile) > 1) {
+		return BLOCK_DIAGONAL;
 	}
+
+	return GENERAL;
 }
 
-void Rref::toRref() {
-	for (int i = firstNonZeroRow; i < H; i++) {
-		int index = rows[i].pivotIndex;
+int Rref::findBlocks(Profile& profile) {
+	std::vector<int>& root = profile.block;
+	root.resize(W);
+	std::iota(root.begin(), root.end(), 0);
 
-		/*
-		   Check the pivot column
-		   to see if a number
-		   other than zero is present.
-		   Perform row addition if
-		   necessary.
-		 */
-		for (int j = firstNonZeroRow; j < i; j++) {
+	auto find = [&root](int j) {
+		while (root[j] != j) {
+			root[j] = root[root[j]];
+			j = root[j];
+		}
+
+		return j;
+	};
+
+	for (int i = 0; i < profile.nonzero; i++) {
+		double* row = profile.a[i];
+		int r = find(profile.first[i]);
+
+		for (int j = profile.first[i] + 1; j <= profile.last[i]; j++) {
+			if (std::fabs(row[j]) <= tolerance) {
+				row[j] = 0;
+				continue;
+			}
+
+			int s = find(j);
 
-			if (rows[j][index] != 0) {
-			    rows[j].elementaryAdd(rows[i], index);
+			if (s != r) {
+				root[s] = r;
 			}
 		}
 	}
 
+	for (int j = 0; j < W; j++) {
+		root[j] = find(j);
+	}
+
+	std::vector<char> seen(W, 0);
+	int count = 0;
+
+	for (int i = 0; i < profile.nonzero; i++) {
+		int r = root[profile.first[i]];
+
+		if (!seen[r]) {
+			seen[r] = 1;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void Rref::solveBlocks(Profile& profile) {
+	std::vector<int> index(W, -1);
+	std::vector<std::vector<int>> members;
+	std::vector<std::vector<int>> columns;
+
+	for (int i = 0; i < profile.nonzero; i++) {
+		int r = profile.block[profile.first[i]];
+
+		if (index[r] == -1) {
+			index[r] = members.size();
+			members.emplace_back();
+			columns.emplace_back();
+		}
+
+		members[index[r]].push_back(i);
+	}
+
 	/*
-	   Make pivot of each row 1. We have now
-	   solved the matrix.
+	   Columns that are zero in every row
+	   belong to no block and stay zero
 	 */
-	for (int i = firstNonZeroRow; i < H; i++) {
-		rows[i] /= rows[i][rows[i].pivotIndex];
+	for (int j = 0; j < W; j++) {
+		int b = index[profile.block[j]];
+
+		if (b != -1) {
+			columns[b].push_back(j);
+		}
+	}
+
+	int threads = 1;
+
+	if ((long)W * H >= PARALLEL_MIN) {
+		threads = std::thread::hardware_concurrency();
+	}
+
+	parallel(members.size(), threads, [&](int b) {
+		solveBlock(profile.a, members[b], columns[b]);
+	});
+}
+
+void Rref::parallel(int count, int threads,
+		const std::function<void(int)>& work) {
+	threads = std::max(1, std::min(count, threads));
+	std::atomic<int> next(0);
+
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	auto run = [&]() {
+		try {
+			for (int i = next++; i < count; i = next++) {
+				work(i);
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+
+	for (int t = 1; t < threads; t++) {
+		pool.emplace_back(run);
+	}
+
+	run();
+
+	for (auto& thread : pool) {
+		thread.join();
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void Rref::tournament() {
+	if (reduced <= 2 * W) {
+		return;
+	}
+
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+	int blocks = std::max(1, std::min(threads, reduced / (2 * W)));
+	std::vector<std::vector<int>> winners(blocks);
+
+	/*
+	   Each block runs its own flat tree: the
+	   winners so far play the next W rows
+	 */
+	parallel(blocks, threads, [&](int b) {
+		int begin = (long)reduced * b / blocks;
+		int end = (long)reduced * (b + 1) / blocks;
+
+		for (int start = begin; start < end; start += W) {
+			for (int i = start; i < std::min(start + W, end); i++) {
+				winners[b].push_back(i);
+			}
+
+			select(winners[b]);
+		}
+	});
+
+	/*
+	   Blocks meet pairwise, one synchronization
+	   per level of the tree
+	 */
+	for (int step = 1; step < blocks; step *= 2) {
+		int pairs = (blocks + 2 * step - 1) / (2 * step);
+
+		parallel(pairs, threads, [&](int t) {
+			int left = 2 * step * t;
+			int right = left + step;
+
+			if (right >= blocks) {
+				return;
+			}
+
+			winners[left].insert(winners[left].end(),
+					winners[right].begin(), winners[right].end());
+			select(winners[left]);
+		});
+	}
+
+	std::vector<int>& kept = winners[0];
+	std::sort(kept.begin(), kept.end());
+
+	/*
+	   kept[t] >= t, and no slot is
+	   written after it was read
+	 */
+	for (size_t t = 0; t < kept.size(); t++) {
+		std::swap(rows[t].data, rows[kept[t]].data);
+	}
+
+	for (int i = kept.size(); i < reduced; i++) {
+		std::fill(rows[i].data, rows[i].data + W, 0);
+	}
+
+	reduced = kept.size();
+}
+
+void Rref::select(std::vector<int>& candidates) const {
+	int n = candidates.size();
+	std::vector<double> copy((size_t)n * W);
+	std::vector<double*> a(n);
+
+	for (int i = 0; i < n; i++) {
+		a[i] = copy.data() + (size_t)i * W;
+		std::copy(rows[candidates[i]].data,
+				rows[candidates[i]].data + W, a[i]);
+	}
+
+	/*
+	   Same test as Rref::threshold(),
+	   kept local to this round
+	 */
+	double limit = tolerance;
+	std::vector<double> spread(W);
+	int k = 0;
+
+	for (int c = 0; c < W && k < n; c++) {
+		int p = k;
+
+		for (int i = k + 1; i < n; i++) {
+			if (std::fabs(a[i][c]) > std::fabs(a[p][c])) {
+				p = i;
+			}
+		}
+
+		if (std::fabs(a[p][c]) <= limit * (1 + spread[c])) {
+			continue;
+		}
+
+		std::swap(a[k], a[p]);
+		std::swap(candidates[k], candidates[p]);
+
+		double* pivot = a[k];
+		double size = 0;
+		double maxL = 0;
+
+		for (int j = c + 1; j < W; j++) {
+			size = std::max(size, std::fabs(pivot[j]));
+			spread[j] = std::max(spread[j],
+					std::fabs(pivot[j] / pivot[c]));
+		}
+
+		for (int i = k + 1; i < n; i++) {
+			double* row = a[i];
+			double l = row[c] / pivot[c];
+
+			if (l == 0) {
+				continue;
+			}
+
+			for (int j = c + 1; j < W; j++) {
+				row[j] -= l * pivot[j];
+			}
+
+			maxL = std::max(maxL, std::fabs(l));
+		}
+
+		limit = std::max(limit,
+				std::max(W, H) * DBL_EPSILON * maxL * size);
+
+		k++;
+	}
+
+	candidates.resize(k);
+}
+
+void Rref::solveBlock(std::vector<double*>& a,
+		const std::vector<int>& members,
+		const std::vector<int>& columns) const {
+	int w = columns.size();
+	std::vector<RowData> block;
+	block.reserve(members.size());
+
+	for (int i : members) {
+		block.emplace_back(w);
+		double* out = block.back().data;
+
+		for (int j = 0; j < w; j++) {
+			out[j] = a[i][columns[j]];
+		}
+	}
+
+	Rref solved(std::move(block), *this);
+
+	/*
+	   Entries outside the block's columns are
+	   already 0, so only those are written back
+	 */
+	for (size_t t = 0; t < members.size(); t++) {
+		double* row = a[members[t]];
+		const double* in = solved.rows[t].data;
+
+		for (int j = 0; j < w; j++) {
+			row[columns[j]] = in[j];
+		}
+	}
+}
+
+void Rref::bandedEchelon(Profile& profile, std::vector<int>& pivots) {
+	std::vector<double*>& a = profile.a;
+	std::vector<int>& first = profile.first;
+	std::vector<int>& last = profile.last;
+	int n = profile.nonzero;
+	int k = 0;
+	int end = 0;
+
+	spread.assign(W, 0);
+
+	for (int c = 0; c < W && k < n; c++) {
+
+		/*
+		   Rows [k, end) are the only ones
+		   that can have an entry in column c
+		 */
+		while (end < n && first[end] <= c) {
+			end++;
+		}
+
+		if (k == end) {
+			continue;
+		}
+
+		int p = k;
+
+		for (int i = k + 1; i < end; i++) {
+			if (std::fabs(a[i][c]) > std::fabs(a[p][c])) {
+				p = i;
+			}
+		}
+
+		if (std::fabs(a[p][c]) <= threshold(c)) {
+			for (int i = k; i < end; i++) {
+				a[i][c] = 0;
+			}
+
+			continue;
+		}
+
+		std::swap(a[k], a[p]);
+		std::swap(first[k], first[p]);
+		std::swap(last[k], last[p]);
+
+		double* pivot = a[k];
+		double size = 0;
+		double maxL = 0;
+
+		for (int j = c + 1; j <= last[k]; j++) {
+			size = std::max(size, std::fabs(pivot[j]));
+		}
+
+		recordPivot(pivot, c, c + 1, last[k] + 1);
+
+		for (int i = k + 1; i < end; i++) {
+			double* row = a[i];
+			double l = row[c] / pivot[c];
+
+			row[c] = 0;
+
+			if (l == 0) {
+				continue;
+			}
+
+			for (int j = c + 1; j <= last[k]; j++) {
+				row[j] -= l * pivot[j];
+			}
+
+			last[i] = std::max(last[i], last[k]);
+			maxL = std::max(maxL, std::fabs(l));
+		}
+
+		raiseTolerance(maxL * size);
+
+		pivots.push_back(c);
+		k++;
+	}
+
+	for (int i = k; i < n; i++) {
+		std::fill(a[i], a[i] + W, 0);
+	}
+}
+
+void Rref::bandedBackSubstitute(Profile& profile,
+		const std::vector<int>& pivots) {
+	std::vector<double*>& a = profile.a;
+	std::vector<int>& last = profile.last;
+	int rank = pivots.size();
+
+	/*
+	   Clearing a pivot column never writes to an
+	   earlier pivot column, so row i can only have
+	   an entry in pivot column c if it reached c
+	   before the back substitution started
+	 */
+	std::vector<int> reach(rank);
+
+	for (int i = 0; i < rank; i++) {
+		reach[i] = std::max(i > 0 ? reach[i - 1] : -1, last[i]);
+	}
+
+	for (int k = rank - 1; k >= 0; k--) {
+		double* pivot = a[k];
+		int c = pivots[k];
+		int end = last[k];
+		double scale = 1 / pivot[c];
+
+		for (int j = c + 1; j <= end; j++) {
+			pivot[j] *= scale;
+		}
+
+		pivot[c] = 1;
+
+		int top = std::lower_bound(reach.begin(), reach.begin() + k, c)
+				- reach.begin();
+
+		for (int i = top; i < k; i++) {
+			double* row = a[i];
+			double factor = row[c];
+
+			if (factor == 0) {
+				continue;
+			}
+
+			for (int j = c + 1; j <= end; j++) {
+				row[j] -= factor * pivot[j];
+			}
+
+			row[c] = 0;
+			last[i] = std::max(last[i], end);
+		}
+	}
+}
+
+void Rref::setRowInfo() {
+	for (int i = firstNonZeroRow; i < H; i++) {
+		rows[i].setRowInfo(tolerance);
+	}
+
+	/*
+	   Moves all zero rows to the top
+	   of the matrix Rref::rows.
+	 */
+	std::sort(rows.begin(), rows.end());
+
+
+	int i = 0;
+	for ( ; i < H; i++) {
+		if (rows[i]) {
+			firstNonZeroRow = i;
+			break;
+		}
+	}
+
+	zeroMatrix = (i == H);
+}
+
+void Rref::setTolerance() {
+	double norm = 0;
+
+	for (auto& row : rows) {
+		double sum = 0;
+
+		for (auto& e : row) {
+			sum += std::fabs(e);
+		}
+
+		norm = std::max(norm, sum);
+	}
+
+	tolerance = std::max(W, H) * DBL_EPSILON * norm;
+}
+
+void Rref::deduplicate() {
+	std::unordered_multimap<uint64_t, int> seen;
+	std::vector<double> normalized(W);
+	int kept = 0;
+
+	for (int i = 0; i < reduced; i++) {
+		double* row = rows[i].data;
+		int first = 0;
+
+		while (first < W && std::fabs(row[first]) <= tolerance) {
+			first++;
+		}
+
+		/*
+		   Zero rows are dropped
+		 */
+		if (first == W) {
+			continue;
+		}
+
+		/*
+		   Multiples of a row share the same row
+		   divided by its first nonzero. Rounded to
+		   float precision so rounding noise from
+		   the division doesn't change the hash.
+		 */
+		for (int j = 0; j < W; j++) {
+			normalized[j] = std::fabs(row[j]) <= tolerance
+					? 0 : (double)(float)(row[j] / row[first]);
+		}
+
+		MatrixHash hasher;
+		hasher.update(normalized.data(), W);
+		uint64_t hash = hasher.digest();
+
+		bool duplicate = false;
+		auto range = seen.equal_range(hash);
+
+		for (auto it = range.first; it != range.second; ++it) {
+			if (isMultiple(rows[it -> second].data, row, first)) {
+				duplicate = true;
+				break;
+			}
+		}
+
+		if (duplicate) {
+			continue;
+		}
+
+		/*
+		   Kept rows are packed at the top,
+		   dropped rows end up below them
+		 */
+		std::swap(rows[kept].data, rows[i].data);
+		seen.emplace(hash, kept);
+		kept++;
+	}
+
+	for (int i = kept; i < reduced; i++) {
+		std::fill(rows[i].begin(), rows[i].end(), 0);
+	}
+
+	reduced = kept;
+}
+
+bool Rref::isMultiple(const double* a, const double* b, int first) {
+	if (std::fabs(a[first]) <= tolerance) {
+		return false;
+	}
+
+	for (int j = 0; j < W; j++) {
+		bool zeroA = std::fabs(a[j]) <= tolerance;
+		bool zeroB = std::fabs(b[j]) <= tolerance;
+
+		if (zeroA != zeroB) {
+			return false;
+		}
+
+		if (zeroA) {
+			continue;
+		}
+
+		double x = a[j] / a[first];
+		double y = b[j] / b[first];
+
+		if (std::fabs(x - y) > 8 * DBL_EPSILON
+				* std::max(std::fabs(x), std::fabs(y))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Rref::equilibrate(std::vector<double>& columnScale) {
+
+	/*
+	   Scale factors are powers of 2, so
+	   scaling and unscaling are exact
+	 */
+	for (int i = 0; i < reduced; i++) {
+		double max = 0;
+
+		for (auto& e : rows[i]) {
+			max = std::max(max, std::fabs(e));
+		}
+
+		if (max > 0) {
+			rows[i] *= std::ldexp(1, -std::ilogb(max));
+		}
+	}
+
+	columnScale.assign(W, 0);
+
+	for (int i = 0; i < reduced; i++) {
+		for (int j = 0; j < W; j++) {
+			columnScale[j] = std::max(columnScale[j],
+					std::fabs(rows[i][j]));
+		}
+	}
+
+	for (auto& e : columnScale) {
+		e = e > 0 ? std::ldexp(1, -std::ilogb(e)) : 1;
+	}
+
+	for (int i = 0; i < reduced; i++) {
+		for (int j = 0; j < W; j++) {
+			rows[i][j] *= columnScale[j];
+		}
+	}
+}
+
+void Rref::unscale(const std::vector<double>& columnScale) {
+
+	/*
+	   Row i of the rref of A * D is row i of the
+	   rref of A times D, divided by the scale of
+	   its pivot column. Row scaling doesn't change
+	   the rref, so there is nothing to undo for it.
+	 */
+	for (int i = firstNonZeroRow; i < H; i++) {
+		double* row = rows[i].data;
+		double pivotScale = columnScale[rows[i].pivotIndex];
+
+		for (int j = 0; j < W; j++) {
+			row[j] *= pivotScale / columnScale[j];
+		}
+	}
+}
+
+int Rref::pivotRow(int k, int c) {
+	int p = k;
+	double max = std::fabs(rows[k][c]);
+
+	for (int i = k + 1; i < reduced; i++) {
+		double e = std::fabs(rows[i][c]);
+
+		if (e > max) {
+			max = e;
+			p = i;
+		}
+	}
+
+	return p;
+}
+
+void Rref::gaussJordan() {
+	spread.assign(W, 0);
+	int k = 0;
+
+	for (int c = 0; c < W && k < reduced; c++) {
+		int p = pivotRow(k, c);
+
+		/*
+		   Nothing but rounding noise left
+		   in this column, so it has no pivot
+		 */
+		if (std::fabs(rows[p][c]) <= threshold(c)) {
+			for (int i = k; i < reduced; i++) {
+				rows[i][c] = 0;
+			}
+
+			continue;
+		}
+
+		std::swap(rows[k].data, rows[p].data);
+		eliminate(k, c, c + 1, 0);
+		k++;
+	}
+}
+
+void Rref::eliminate(int k, int c, int first, int top) {
+	double* pivot = rows[k].data;
+	double scale = 1 / pivot[c];
+	double size = 0;
+
+	pivot[c] = 1;
+
+	for (int j = first; j < W; j++) {
+		pivot[j] *= scale;
+	}
+
+	for (int j = c + 1; j < W; j++) {
+		size = std::max(size, std::fabs(pivot[j]));
+	}
+
+	recordPivot(pivot, c, c + 1, W);
+
+	double maxFactor = 0;
+
+	for (int i = top; i < reduced; i++) {
+		double* row = rows[i].data;
+		double factor = row[c];
+
+		if (i == k || factor == 0) {
+			continue;
+		}
+
+		row[c] = 0;
+
+		for (int j = first; j < W; j++) {
+			row[j] -= factor * pivot[j];
+		}
+
+		/*
+		   Rows above already have their pivot,
+		   their noise can't become one
+		 */
+		if (i > k) {
+			maxFactor = std::max(maxFactor, std::fabs(factor));
+		}
+	}
+
+	/*
+	   factor is the entry of row i before the
+	   update, and size is relative to the pivot,
+	   so their product is |l| * the largest
+	   entry of the pivot row before scaling
+	 */
+	raiseTolerance(maxFactor * size);
+}
+
+void Rref::raiseTolerance(double update) {
+	tolerance = std::max(tolerance,
+			std::max(W, H) * DBL_EPSILON * update);
+}
+
+void Rref::recordPivot(const double* pivot, int c, int begin, int end) {
+	double scale = 1 / std::fabs(pivot[c]);
+
+	for (int j = begin; j < end; j++) {
+		spread[j] = std::max(spread[j], std::fabs(pivot[j]) * scale);
+	}
+}
+
+double Rref::threshold(int c) const {
+	return tolerance * (1 + spread[c]);
+}
+
+void Rref::reduceRowSpace() {
+
+	/*
+	   cols[j] is the column of the matrix
+	   at position j of the permuted matrix.
+	   Positions >= active hold columns found
+	   to be negligible.
+	 */
+	std::vector<int> cols(W);
+	for (int j = 0; j < W; j++) {
+		cols[j] = j;
+	}
+
+	int active = W;
+	int k = 0;
+
+	spread.assign(W, 0);
+
+	while (k < reduced && k < active) {
+		int p = k;
+		int q = k;
+
+		if (pivoting == COMPLETE) {
+
+			/*
+			   Largest entry among those above
+			   the threshold of their column
+			 */
+			double max = 0;
+			p = -1;
+
+			for (int i = k; i < reduced; i++) {
+				for (int j = k; j < active; j++) {
+					double e = std::fabs(rows[i][cols[j]]);
+
+					if (e > max && e > threshold(cols[j])) {
+						max = e;
+						p = i;
+						q = j;
+					}
+				}
+			}
+		} else {
+
+			/*
+			   Alternate between the largest entry of
+			   the column and of the row until one is
+			   the largest of both. Each step strictly
+			   increases the entry, so this ends.
+			 */
+			p = pivotRow(k, cols[q]);
+
+			while (true) {
+				int next = q;
+
+				for (int j = k; j < active; j++) {
+					if (std::fabs(rows[p][cols[j]])
+							> std::fabs(rows[p][cols[next]])) {
+						next = j;
+					}
+				}
+
+				if (next == q) {
+					break;
+				}
+
+				q = next;
+				int row = pivotRow(k, cols[q]);
+
+				if (row == p || std::fabs(rows[row][cols[q]])
+						<= std::fabs(rows[p][cols[q]])) {
+					break;
+				}
+
+				p = row;
+			}
+		}
+
+		if (p == -1) {
+
+			/*
+			   The whole remaining submatrix
+			   is negligible
+			 */
+			break;
+		}
+
+		if (std::fabs(rows[p][cols[q]]) <= threshold(cols[q])) {
+
+			/*
+			   Only column cols[q] is known to be
+			   negligible, move it out of the search
+			 */
+			for (int i = k; i < reduced; i++) {
+				rows[i][cols[q]] = 0;
+			}
+
+			std::swap(cols[q], cols[--active]);
+			continue;
+		}
+
+		std::swap(rows[k].data, rows[p].data);
+		std::swap(cols[k], cols[q]);
+
+		double* pivot = rows[k].data;
+		int c = cols[k];
+		double size = 0;
+		double maxFactor = 0;
+
+		for (int j = k + 1; j < W; j++) {
+			size = std::max(size, std::fabs(pivot[cols[j]]));
+		}
+
+		recordPivot(pivot, c, 0, W);
+
+		for (int i = k + 1; i < reduced; i++) {
+			double* row = rows[i].data;
+			double factor = row[c] / pivot[c];
+
+			if (factor == 0) {
+				continue;
+			}
+
+			for (int j = k + 1; j < W; j++) {
+				row[cols[j]] -= factor * pivot[cols[j]];
+			}
+
+			row[c] = 0;
+			maxFactor = std::max(maxFactor, std::fabs(factor));
+		}
+
+		raiseTolerance(maxFactor * size);
+
+		k++;
+	}
+
+	/*
+	   Rows past the rank only hold
+	   rounding noise
+	 */
+	for (int i = k; i < reduced; i++) {
+		std::fill(rows[i].begin(), rows[i].end(), 0);
+	}
+}
+
+void Rref::blockedGaussJordan() {
+	std::vector<double*> a(reduced);
+
+	for (int i = 0; i < reduced; i++) {
+		a[i] = rows[i].data;
+	}
+
+	std::vector<int> pivots;
+	std::vector<double> multipliers;
+
+	spread.assign(W, 0);
+
+	int rank = echelon(a, 0, 0, W, pivots, multipliers);
+
+	/*
+	   Multipliers of L are stored in the pivot
+	   columns below each pivot. U has zeros there,
+	   and rows past the rank are all zeros.
+	 */
+	for (int j = 1; j < rank; j++) {
+		for (int t = 0; t < j; t++) {
+			a[j][pivots[t]] = 0;
+		}
+	}
+
+	for (int i = rank; i < reduced; i++) {
+		std::fill(a[i], a[i] + W, 0);
+	}
+
+	backSubstitute(a, pivots);
+
+	for (int i = 0; i < reduced; i++) {
+		rows[i].data = a[i];
+	}
+}
+
+int Rref::echelon(std::vector<double*>& a, int k, int c0, int c1,
+		std::vector<int>& pivots, std::vector<double>& multipliers) {
+	if (k >= reduced) {
+		return 0;
+	}
+
+	if (c1 - c0 <= RECURSION_BASE) {
+		int r = 0;
+
+		for (int c = c0; c < c1 && k + r < reduced; c++) {
+			int top = k + r;
+			int p = top;
+
+			for (int i = top + 1; i < reduced; i++) {
+				if (std::fabs(a[i][c]) > std::fabs(a[p][c])) {
+					p = i;
+				}
+			}
+
+			if (std::fabs(a[p][c]) <= threshold(c)) {
+				for (int i = top; i < reduced; i++) {
+					a[i][c] = 0;
+				}
+
+				continue;
+			}
+
+			std::swap(a[top], a[p]);
+			double* pivot = a[top];
+			double size = 0;
+			double maxL = 0;
+
+			for (int j = c + 1; j < c1; j++) {
+				size = std::max(size, std::fabs(pivot[j]));
+			}
+
+			recordPivot(pivot, c, c + 1, c1);
+
+			for (int i = top + 1; i < reduced; i++) {
+				double* row = a[i];
+				double l = row[c] / pivot[c];
+
+				/*
+				   The multiplier is kept where
+				   the eliminated entry was
+				 */
+				row[c] = l;
+
+				if (l == 0) {
+					continue;
+				}
+
+				for (int j = c + 1; j < c1; j++) {
+					row[j] -= l * pivot[j];
+				}
+
+				maxL = std::max(maxL, std::fabs(l));
+			}
+
+			raiseTolerance(maxL * size);
+			pivots.push_back(c);
+			multipliers.push_back(maxL);
+			r++;
+		}
+
+		return r;
+	}
+
+	int mid = c0 + (c1 - c0) / 2;
+	int first = pivots.size();
+	int r1 = echelon(a, k, c0, mid, pivots, multipliers);
+
+	if (r1 > 0) {
+
+		/*
+		   Pivot rows of the left half:
+		   A12 = L11^-1 * A12
+		 */
+		lowerSolve(a, k, r1, pivots, first, mid, c1);
+
+		/*
+		   The base case only saw the pivot rows
+		   up to column mid, their part in
+		   [mid, c1) is known now
+		 */
+		for (int t = 0; t < r1; t++) {
+			const double* pivot = a[k + t];
+			double size = 0;
+
+			for (int j = mid; j < c1; j++) {
+				size = std::max(size, std::fabs(pivot[j]));
+			}
+
+			recordPivot(pivot, pivots[first + t], mid, c1);
+			raiseTolerance(multipliers[first + t] * size);
+		}
+
+		/*
+		   Rows below: A22 -= L21 * A12
+		 */
+		Gemm::subtract(reduced - k - r1, c1 - mid, r1,
+				a.data() + k + r1, pivots.data() + first,
+				a.data() + k, mid, a.data() + k + r1, mid);
+	}
+
+	return r1 + echelon(a, k + r1, mid, c1, pivots, multipliers);
+}
+
+void Rref::lowerSolve(std::vector<double*>& a, int k, int r,
+		const std::vector<int>& pivots, int first, int c0, int c1) {
+	if (r <= RECURSION_BASE) {
+		for (int j = 1; j < r; j++) {
+			double* row = a[k + j];
+
+			for (int t = 0; t < j; t++) {
+				double l = row[pivots[first + t]];
+
+				if (l == 0) {
+					continue;
+				}
+
+				double* src = a[k + t];
+
+				for (int q = c0; q < c1; q++) {
+					row[q] -= l * src[q];
+				}
+			}
+		}
+
+		return;
+	}
+
+	int h = r / 2;
+	lowerSolve(a, k, h, pivots, first, c0, c1);
+
+	Gemm::subtract(r - h, c1 - c0, h,
+			a.data() + k + h, pivots.data() + first,
+			a.data() + k, c0, a.data() + k + h, c0);
+
+	lowerSolve(a, k + h, r - h, pivots, first + h, c0, c1);
+}
+
+void Rref::backSubstitute(std::vector<double*>& a,
+		const std::vector<int>& pivots) {
+	int rank = pivots.size();
+
+	for (int j1 = rank; j1 > 0; j1 -= RECURSION_BASE) {
+		int j0 = std::max(0, j1 - RECURSION_BASE);
+
+		for (int j = j1 - 1; j >= j0; j--) {
+			double* row = a[j];
+			int c = pivots[j];
+			double scale = 1 / row[c];
+
+			for (int q = c + 1; q < W; q++) {
+				row[q] *= scale;
+			}
+
+			row[c] = 1;
+
+			for (int i = j0; i < j; i++) {
+				double l = a[i][c];
+
+				if (l == 0) {
+					continue;
+				}
+
+				for (int q = c + 1; q < W; q++) {
+					a[i][q] -= l * row[q];
+				}
+
+				a[i][c] = 0;
+			}
+		}
+
+		if (j0 == 0) {
+			break;
+		}
+
+		/*
+		   Rows above the block:
+		   A0 -= A0[pivot columns] * block
+		 */
+		int nb = j1 - j0;
+		int c = pivots[j0];
+
+		Gemm::subtract(j0, W - c, nb, a.data(), pivots.data() + j0,
+				a.data() + j0, c, a.data(), c);
+
+		for (int i = 0; i < j0; i++) {
+			for (int t = 0; t < nb; t++) {
+				a[i][pivots[j0 + t]] = 0;
+			}
+		}
 	}
 }
@@ -1,6 +1,8 @@
 #ifndef RREF_H_
 #define RREF_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -29,33 +31,177 @@
    This class contains a matrix represented by
    std::vector<RowData> rows(see RowData.h).
    Rref is performed on this matrix after
-   initialization in a call to solve(),
-   which contains the main loop for the program.
-
-   The program exits solve() when
-           -the matrix is a zero matrix(see bool zeroMatrix)
-           -matrix is in rref form, which
-           occurs after isRef() evaluates true
-
-   As a student does in real life,
-   solve() will keep making passes over
-   the matrix until it is in ref form (see isRef()).
-   These passes are performed via doAnRefPass().
-   This function checks the pivots of the rows
-   and performs row operations when necessary
-
-   Once solve() finds that isRef() evaluates to
-   true, toRref() is executed to transform the matrix
-   from ref to rref. This occurs only once.
+   initialization in a call to solve().
+
+   solve() runs Gauss-Jordan elimination column
+   by column. For each column, the row with the
+   largest magnitude entry becomes the pivot
+   (partial pivoting), the pivot is scaled to 1,
+   and the column is cleared in every other row.
+
+   An entry counts as zero when its magnitude is
+   at most Rref::tolerance, which is scaled by the
+   norm of the matrix. Rounding noise such as 1e-17
+   is never taken as a pivot, so the amount of work
+   depends only on the shape of the matrix. The
+   tolerance grows with the largest row update, and
+   each column's threshold with how far the pivot
+   rows reach into it relative to their pivot (see
+   Rref::threshold()), so noise left by a cancellation
+   isn't taken as a pivot either.
+
+   For matrices with at least BLOCKED_MIN rows
+   and columns, the same elimination is done in
+   blocks (see Rref::blockedGaussJordan()), so
+   most of the work is matrix multiplies done by
+   the cache blocked kernel in Gemm.h.
+
+   Before elimination, the rows are scanned once
+   for structure (see Rref::Structure). Matrices
+   that are already in row echelon form, banded,
+   or block diagonal after a permutation are sent
+   to solvers whose cost follows that structure
+   instead of W * H.
+
+   Rook or complete pivoting can be requested
+   instead (see Rref::Pivoting). They first find
+   the rank and a basis of the row space with a
+   stronger pivot search, then Gauss-Jordan
+   elimination is run on that basis.
+
+   Optional preprocessing (see Rref::Preprocess)
+   drops zero rows, duplicate rows and rows that
+   are multiples of others before elimination,
+   and equilibrates the matrix by scaling its
+   rows and columns.
+
+   Zero rows are moved to the top of the
+   solved matrix(see RowData::operator<).
 
    Author: Trevor Lash
 
-   Revised: 6/11/23
+   Revised: 10/18/26
  */
 class Rref {
 
+	public:
+
+		/*
+		   How pivots are chosen
+
+		   PARTIAL-> largest magnitude entry of the column
+		   ROOK-> entry that is the largest in both its
+		   row and its column
+		   COMPLETE-> largest magnitude entry of the
+		   remaining submatrix
+		 */
+		enum Pivoting { PARTIAL, ROOK, COMPLETE };
+
+		/*
+		   Flags for the preprocessing done
+		   before elimination. They can be
+		   combined with |.
+
+		   DEDUPLICATE-> rows are hashed after
+		   dividing them by their first nonzero.
+		   Zero rows, and rows equal to a multiple
+		   of an earlier row, are dropped from the
+		   elimination and come out as zero rows.
+		   O(H * W)
+		   EQUILIBRATE-> rows, then columns, are
+		   scaled by powers of 2 so their largest
+		   entry is in [1, 2). Column scaling is
+		   undone on the result.
+		   TOURNAMENT-> for tall matrices. The rows are
+		   split into one block per thread, each block
+		   picks at most W candidate pivot rows with an
+		   LU of its own, and candidates are merged pairwise
+		   in a reduction tree (CALU tournament pivoting).
+		   Only the winners, a basis of the row space,
+		   take part in elimination.
+		 */
+		enum Preprocess { NONE = 0, DEDUPLICATE = 1, EQUILIBRATE = 2,
+				TOURNAMENT = 4 };
+
+		/*
+		   Structure found before elimination,
+		   checked in this order
+
+		   ECHELON-> the leading entries of the nonzero
+		   rows move strictly right. Only the back
+		   substitution is done.
+		   BANDED-> rows are sorted by leading entry and
+		   the lower and upper bandwidths add up to at
+		   most W / 4. Elimination only touches the rows
+		   and columns inside the band.
+		   BLOCK_DIAGONAL-> rows and columns split into
+		   independent blocks, possibly after a permutation.
+		   Each block is solved on its own, in parallel
+		   for large matrices.
+		   GENERAL-> none of the above
+		 */
+		enum Structure { GENERAL, ECHELON, BANDED, BLOCK_DIAGONAL };
+
 	private:
 
+		/*
+		   Matrices with fewer rows or columns
+		   are reduced by Rref::gaussJordan(),
+		   larger ones by Rref::blockedGaussJordan()
+		 */
+		static const int BLOCKED_MIN = 96;
+
+		/*
+		   Width of the blocks below which the
+		   recursive functions stop splitting
+		 */
+		static const int RECURSION_BASE = 32;
+
+		/*
+		   Block diagonal matrices with at least
+		   this many entries solve their blocks
+		   on several threads
+		 */
+		static const long PARALLEL_MIN = 1 << 16;
+
+		/*
+		   Rows of the matrix as seen by
+		   Rref::analyze()
+		 */
+		struct Profile {
+
+			/*
+			   Row pointers, nonzero
+			   rows first
+			 */
+			std::vector<double*> a;
+
+			/*
+			   Columns of the first and last entry
+			   above Rref::tolerance of each nonzero row
+			 */
+			std::vector<int> first;
+			std::vector<int> last;
+
+			/*
+			   Amount of nonzero rows
+			 */
+			int nonzero;
+
+			/*
+			   Largest i - first[i] and
+			   last[i] - first[i]
+			 */
+			int lower;
+			int upper;
+
+			/*
+			   Block of each column, set
+			   by Rref::findBlocks()
+			 */
+			std::vector<int> block;
+		};
+
 		/*
 		   Width of matrix.
 		 */
@@ -67,19 +213,55 @@ class Rref {
 		int H;
 
 		/*
-		   Allows us to ignore
-		   zero rows when making
-		   passes over the matrix
+		   Index of the first nonzero row
+		   once the matrix is solved
 		 */
 		int firstNonZeroRow;
 
 		/*
 		   A flag that is set to true
 		   if matrix is all zeros.
-		   This lets solve() terminate
 		 */
 		bool zeroMatrix;
 
+		Pivoting pivoting;
+
+		/*
+		   Rref::Preprocess flags
+		 */
+		int preprocess;
+
+		/*
+		   Entries with a magnitude <= tolerance
+		   are treated as zero. Set by solve() to
+		   max(W, H) * DBL_EPSILON * ||A||inf, and
+		   raised during elimination when a row
+		   update is larger than that norm (see
+		   Rref::raiseTolerance())
+		 */
+		double tolerance;
+
+		/*
+		   spread[j] is the largest |u[t][j] / u[t][t]|
+		   over the pivot rows found so far by the
+		   running elimination, reset when it starts.
+		   Rounding error in a pivot is carried into
+		   column j by that ratio, so an entry that
+		   should cancel there may be left this much
+		   above Rref::tolerance.
+		 */
+		std::vector<double> spread;
+
+		/*
+		   Amount of rows taking part in
+		   elimination. Rows past it were
+		   dropped by Rref::deduplicate()
+		   and are all zeros.
+		 */
+		int reduced;
+
+		Structure structure;
+
 		/*
 		   The matrix. Each RowData
 		   contains one row of the matrix/
@@ -99,12 +281,15 @@ class Rref {
 
 		   Parameters:
 		   url-> name of text file
+		   pivoting-> see Rref::Pivoting
+		   preprocess-> see Rref::Preprocess
 
 		  Throws:
 		  std::ifstream::failure-> file read error
 		  std::invalid_argument-> row lengths are inconsistent
 	     */
-		Rref(std::string url);
+		Rref(std::string url, Pivoting pivoting = PARTIAL,
+				int preprocess = NONE);
 
 		/*
 		   Takes the user-provided matrix and converts it into rref form.
@@ -116,7 +301,21 @@ class Rref {
 		   rref makes a copy of the matrix. user's responsibility
 		   to delete original matrix.
 		 */
-		Rref(double** matrix, int W, int H);
+		Rref(double** matrix, int W, int H,
+				Pivoting pivoting = PARTIAL, int preprocess = NONE);
+
+		/*
+		   Takes ownership of already parsed rows
+		   (see MatrixReader.h) and converts them
+		   into rref form. No copy of the data is made.
+
+		   Throws:
+		   std::invalid_argument-> rows is empty, or
+		   rows are not all the same width
+		 */
+		Rref(std::vector<RowData>&& rows,
+				Pivoting pivoting = PARTIAL, int preprocess = NONE);
+
 		Rref(const Rref& other);
 		Rref(Rref&& other) noexcept;
 
@@ -125,61 +324,446 @@ class Rref {
 		Rref& operator=(const Rref& other);
 		Rref& operator=(Rref&& other) noexcept;
 
+		/*
+		   Reads the rows of a matrix from a file,
+		   in the format of Rref(std::string), without
+		   solving it. Used to look a matrix up in an
+		   RrefCache before solving.
+
+		   Parameters:
+		   url-> name of text file
+		   hash-> if not nullptr, set to the MatrixHash
+		   of the matrix, computed while parsing
+
+		   Throws:
+		   std::ifstream::failure-> file read error
+		   std::invalid_argument-> row lengths are inconsistent
+		 */
+		static std::vector<RowData> parse(std::string url,
+				uint64_t* hash = nullptr);
+
 		/*
 		   Deep copy of matrix
 		 */
-		double** getMatrix();
-		void printMatrix();
+		double** getMatrix() const;
+
+		/*
+		   Rows of the solved matrix,
+		   without a copy
+		 */
+		const std::vector<RowData>& getRows() const;
+
+		/*
+		   Amount of nonzero rows
+		   of the solved matrix
+		 */
+		int rank() const;
+
+		/*
+		   Threshold below which entries
+		   were treated as zero. Columns that
+		   depend on a small pivot were held
+		   to a higher one (see Rref::threshold()).
+		 */
+		double getTolerance() const;
+
+		/*
+		   Structure the matrix was solved with.
+		   Always GENERAL for rook or complete
+		   pivoting.
+		 */
+		Structure getStructure() const;
+
+		/*
+		   Writes the pivot columns of the solved
+		   matrix, in increasing order, to columns,
+		   which must hold rank() numbers.
+
+		   Returns rank()
+		 */
+		int pivotColumns(int* columns) const;
+
+		/*
+		   Writes the columns without a pivot, in
+		   increasing order, to columns, which must
+		   hold W - rank() numbers.
+
+		   Returns W - rank()
+		 */
+		int freeColumns(int* columns) const;
+
+		/*
+		   Writes a basis of the nullspace {x : Ax = 0}
+		   to basis, one vector of W numbers after the
+		   other, which must hold (W - rank()) * W numbers.
+
+		   The vector of free column f has a 1 at f,
+		   -R[r][f] at the pivot column of each row r
+		   of the rref R, and 0 elsewhere. Vectors are
+		   in the order of freeColumns().
+
+		   Returns W - rank()
+		 */
+		int nullspace(double* basis) const;
+
+		/*
+		   Solution set of a system Ax = b whose
+		   augmented matrix [A | b] was solved:
+		   every solution is particular plus a
+		   combination of the homogeneous vectors.
+
+		   Parameters:
+		   particular-> W - 1 numbers, set to the
+		   solution with every free variable at 0
+		   homogeneous-> if not nullptr, set to a basis
+		   of the nullspace of A, as by nullspace():
+		   W - 1 - rank() vectors of W - 1 numbers
+
+		   Returns the amount of homogeneous vectors,
+		   or -1, with nothing written, if the system
+		   has no solution (column b has a pivot)
+		 */
+		int solution(double* particular,
+				double* homogeneous = nullptr) const;
+
+		/*
+		   Inverse of an N x N matrix by Gauss-Jordan
+		   elimination with partial pivoting, done in
+		   place on the returned copy: the columns of the
+		   identity are never stored, each eliminated
+		   column of the matrix holds the matching column
+		   of the inverse. Row swaps are undone as column
+		   swaps at the end.
+
+		   Clients are responsible for deleting the
+		   returned matrix, as for getMatrix().
+
+		   Parameters:
+		   matrix-> N rows of N numbers, not modified
+		   N-> size of the matrix
+		   determinant-> if not nullptr, set to the
+		   determinant of matrix (see Rref::determinant())
+
+		   Throws:
+		   std::invalid_argument-> null matrix, invalid
+		   size, or singular matrix: a column with no entry
+		   above the threshold the elimination holds it to,
+		   N * DBL_EPSILON * ||A||inf raised as by
+		   Rref::raiseTolerance() and Rref::threshold(),
+		   reported as soon as that column is reached
+		 */
+		static double** inverse(double** matrix, int N,
+				double* determinant = nullptr);
+
+		/*
+		   Determinant of an N x N matrix, the product of
+		   the pivots of an LU decomposition with partial
+		   pivoting, negated for an odd amount of row swaps.
+		   Done on a copy, with the exponent kept apart
+		   so the product only overflows if the result does.
+
+		   Returns 0 only when a column has no nonzero
+		   entry left to pivot on. Pivots that are just
+		   rounding noise are still multiplied in, so
+		   tiny and huge determinants come back as they
+		   are, and a singular matrix may give a small
+		   nonzero value.
+
+		   Parameters:
+		   singular-> if not nullptr, set to whether
+		   some pivot was at most the threshold
+		   Rref::inverse() would reject it at, that is,
+		   whether the matrix is singular to working
+		   precision
+
+		   Throws:
+		   std::invalid_argument-> null matrix or invalid size
+		 */
+		static double determinant(double** matrix, int N,
+				bool* singular = nullptr);
+
+		/*
+		   Prints matrix with 2 decimals, numbers
+		   with |e| < 1E-3 as 0, each padded with a
+		   space on both sides and each row followed
+		   by a blank line, as " %.2f " and "\n\n".
+		   See MatrixWriter.h for other formats.
+		 */
+		void printMatrix(FILE* out = stdout) const;
 
     private:
 
 		/*
-		   Main loop of program.
-		   While Rref::rows
-		   isn't a Rref::zeroMatrix and Rref::isRef() is false,
-		   this continues to execute.
-		   Rref::doAnRefPass() is called for each loop for an ref pass.
-		   Rref::toRref() is called before exiting the loop
-		   to convert Rref::rows from ref to rref
+		   Solves one block of a block diagonal
+		   matrix with the tolerance of parent
+		 */
+		Rref(std::vector<RowData>&& rows, const Rref& parent);
+
+		/*
+		   Copies an N x N matrix without solving it,
+		   with Rref::tolerance set, for Rref::inverse()
+		   and Rref::determinant() to eliminate with
+		   the same steps as Rref::gaussJordan()
+		 */
+		Rref(double* const* matrix, int N);
+
+		/*
+		   Converts Rref::rows into rref.
+
+		   Sets Rref::tolerance, runs the requested
+		   preprocessing, Rref::reduceRowSpace() for
+		   rook or complete pivoting, then
+		   Rref::reduce(), Rref::setRowInfo(),
+		   and undoes column scaling
 		 */
 		void solve();
 
+		/*
+		   Brings rows [0, Rref::reduced) to rref with
+		   zero rows at the bottom, using the solver for
+		   the structure found by Rref::analyze(), or
+		   Rref::gaussJordan() / Rref::blockedGaussJordan()
+		 */
+		void reduce();
+
+		/*
+		   Fills profile in one pass over the rows and
+		   returns the structure of the matrix (see
+		   Rref::Structure). Entries at most Rref::tolerance
+		   outside [first, last] of a row are set to 0.
+		 */
+		Structure analyze(Profile& profile);
+
+		/*
+		   Splits the columns into blocks connected by
+		   the nonzero rows (union-find), and sets
+		   profile.block. Entries at most Rref::tolerance
+		   are set to 0. Returns the amount of blocks
+		   holding a nonzero row.
+		 */
+		int findBlocks(Profile& profile);
+
+		/*
+		   Solves each block found by Rref::findBlocks()
+		   as its own Rref, on several threads when the
+		   matrix has at least PARALLEL_MIN entries
+		 */
+		void solveBlocks(Profile& profile);
+
+		/*
+		   Runs work(0) ... work(count - 1) on up to
+		   threads threads, the calling one included.
+		   The first exception thrown is rethrown
+		   once every thread is done.
+		 */
+		static void parallel(int count, int threads,
+				const std::function<void(int)>& work);
+
+		/*
+		   Tournament pivoting (see Rref::TOURNAMENT).
+		   Moves the winning rows, in their original
+		   order, to the top, zeros the other rows
+		   and lowers Rref::reduced to the winners.
+		   Does nothing unless Rref::reduced > 2 * W.
+		 */
+		void tournament();
+
+		/*
+		   Keeps the rows of candidates, indices into
+		   Rref::rows, that become pivot rows of an LU
+		   with partial pivoting of a copy of them.
+		   At most W rows are kept. Does not modify
+		   the matrix or Rref::tolerance, so rounds
+		   can run in parallel.
+		 */
+		void select(std::vector<int>& candidates) const;
+
+		/*
+		   Copies the given rows and columns out of a,
+		   solves them, and copies the result back
+		 */
+		void solveBlock(std::vector<double*>& a,
+				const std::vector<int>& members,
+				const std::vector<int>& columns) const;
+
+		/*
+		   Brings the nonzero rows of a BANDED profile to
+		   echelon form with partial pivoting. For column c,
+		   only rows whose first entry is at most c are
+		   searched and updated, and only up to the last
+		   entry of the pivot row. Pivot columns are
+		   appended to pivots, rows past the rank are zeroed,
+		   and profile.last follows the fill.
+		 */
+		void bandedEchelon(Profile& profile, std::vector<int>& pivots);
+
+		/*
+		   Turns the echelon rows of profile into rref.
+		   Each pivot row is only applied to the rows
+		   above it that reach its pivot column, over
+		   the columns up to its last entry.
+		 */
+		void bandedBackSubstitute(Profile& profile,
+				const std::vector<int>& pivots);
+
 		/*
 		   Updates matrix properties
 
-		   Called in Rref::solve() after every ref pass
-		   to update the matrix. It calls RowsInfo::setRowInfo()
-		   on each rowInfo in Rref::rows (the matrix), sorts the matrix
-		   by natural ordering(see RowInfo::operator<(RowInfo&)),
+		   Calls RowData::setRowInfo() on each row,
+		   sorts the matrix by natural ordering
+		   (see RowData::operator<(RowData&)),
 		   and determines the Rref::firstNonZeroRow, as well as whether
 		   or not Rref::rows is a Rref::zeroMatrix.
 		 */
 		void setRowInfo();
 
 		/*
-		   See Rref::setRowInfo
+		   Sets Rref::tolerance from the
+		   infinity norm of the matrix
+		 */
+		void setTolerance();
+
+		/*
+		   Drops zero rows and rows that are
+		   multiples of an earlier row by moving
+		   them below Rref::reduced and zeroing them
+		 */
+		void deduplicate();
+
+		/*
+		   True if row b is a multiple of row a,
+		   up to rounding. first is the index of
+		   the first nonzero of b.
+		 */
+		bool isMultiple(const double* a, const double* b, int first);
+
+		/*
+		   Scales rows and columns by powers of 2.
+		   columnScale is set to the column factors.
 		 */
-		void doAnRefPass();
+		void equilibrate(std::vector<double>& columnScale);
 
 		/*
-		   See Rref::setRowInfo
+		   Turns the rref of the column scaled
+		   matrix into the rref of the original one
 		 */
-		void toRref();
+		void unscale(const std::vector<double>& columnScale);
 
 		/*
-		   Checks if matrix Rref::rows is in Rref
+		   Gauss-Jordan elimination with partial
+		   pivoting. Leaves the matrix in rref with
+		   zero rows at the bottom. Entries that are
+		   treated as zero are set to exactly 0.
+		 */
+		void gaussJordan();
 
-		   Checked after each matrix pass
-		   in Rref::solve(). Once this evaluates
-		   to true, matrix is ready to be
-		   transformed into rref, and
-		   solve calls Rref::toRref().
+		/*
+		   Same result as Rref::gaussJordan(), done as
+		   a PLE decomposition followed by a blocked
+		   back substitution. Works on a, the row
+		   pointers of the first Rref::reduced rows,
+		   and stores the swapped order back in rows.
+		 */
+		void blockedGaussJordan();
 
-		   Returns:
-		   true-> matrix is in ref
-		   false-> matrix is not in ref
+		/*
+		   Recursive LU with partial pivoting of rows
+		   [k, reduced) over columns [c0, c1). Splits
+		   the columns in halves, reduces the left one,
+		   updates the right one with a triangular solve
+		   and a Gemm::subtract(), then reduces it.
+
+		   Columns with no entry above Rref::threshold()
+		   are skipped, so the pivots found, appended to
+		   pivots, give the echelon form of the matrix.
+		   Multipliers are stored in the pivot columns
+		   of the rows below each pivot, and the largest
+		   one of each pivot is appended to multipliers.
+
+		   Returns the amount of pivots found
+		 */
+		int echelon(std::vector<double*>& a, int k, int c0, int c1,
+				std::vector<int>& pivots, std::vector<double>& multipliers);
+
+		/*
+		   Columns [c0, c1) of rows [k, k + r) become
+		   L^-1 times themselves, where L is the unit
+		   lower triangular matrix held in those rows at
+		   columns pivots[first, first + r). Recursive,
+		   with most of the work in Gemm::subtract()
+		 */
+		void lowerSolve(std::vector<double*>& a, int k, int r,
+				const std::vector<int>& pivots, int first, int c0, int c1);
+
+		/*
+		   Turns the echelon rows [0, pivots.size())
+		   into rref, a block of RECURSION_BASE rows at
+		   a time from the bottom. Rows above a block are
+		   updated with one Gemm::subtract()
+		 */
+		void backSubstitute(std::vector<double*>& a,
+				const std::vector<int>& pivots);
+
+		/*
+		   Scales row k so that rows[k][c] is 1,
+		   then clears column c in the other rows
+		   from row top on. Only columns [first, W)
+		   are updated, which must hold every nonzero
+		   of row k besides c.
+
+		   With first <= c, the column of the identity
+		   takes the place of column c before the row
+		   operations, which is how Rref::inverse()
+		   works in place.
+		 */
+		void eliminate(int k, int c, int first, int top);
+
+		/*
+		   Raises Rref::tolerance to cover the rounding
+		   error of a row update of the given size:
+		   largest multiplier applied to the rows below
+		   the pivot * largest entry of the pivot row,
+		   both as they were before the pivot row was
+		   scaled. Updates no larger than the norm of
+		   the matrix leave it unchanged.
+		 */
+		void raiseTolerance(double update);
+
+		/*
+		   Widens Rref::spread over columns
+		   [begin, end) with the pivot row
+		   whose pivot is in column c
+		 */
+		void recordPivot(const double* pivot, int c, int begin, int end);
+
+		/*
+		   Magnitude at or below which an entry
+		   of column c is taken as zero:
+		   Rref::tolerance * (1 + Rref::spread[c])
+		 */
+		double threshold(int c) const;
+
+		/*
+		   Rook or complete pivoting elimination.
+		   Leaves a basis of the row space in the
+		   first rank rows, and zeros in the others.
+		   Columns are swapped during the search
+		   and put back in place at the end.
+		 */
+		void reduceRowSpace();
+
+		/*
+		   Writes the nullspace basis of the first
+		   width columns (see Rref::nullspace())
+		   and returns the amount of vectors
+		 */
+		int nullBasis(double* basis, int width) const;
+
+		/*
+		   Returns the index of the row in [k, reduced)
+		   with the largest magnitude entry in column c
 		 */
-		bool isRef();
+		int pivotRow(int k, int c);
 };
 
 #endif
@@ -0,0 +1,153 @@
+#include <stdexcept>
+
+#include "MatrixHash.h"
+#include "RrefCache.h"
+
+bool RrefCache::Key::operator==(const Key& that) const {
+	return hash == that.hash && W == that.W
+			&& H == that.H && pivoting == that.pivoting
+			&& preprocess == that.preprocess;
+}
+
+size_t RrefCache::KeyHash::operator()(const Key& key) const {
+	return key.hash;
+}
+
+RrefCache::RrefCache(size_t maxBytes) {
+	this -> maxBytes = maxBytes;
+	used = 0;
+	hitCount = 0;
+	missCount = 0;
+}
+
+std::shared_ptr<const Rref> RrefCache::solve(std::string url,
+		Rref::Pivoting pivoting, int preprocess) {
+	uint64_t hash;
+	std::vector<RowData> rows = Rref::parse(url, &hash);
+
+	return solve(std::move(rows), hash, pivoting, preprocess);
+}
+
+std::shared_ptr<const Rref> RrefCache::solve(double** matrix, int W, int H,
+		Rref::Pivoting pivoting, int preprocess) {
+	if (!matrix) {
+		throw std::invalid_argument(
+				"\nrref::RrefCache::solve(double**, int, int)->"
+				"null matrix\n");
+	}
+
+	if (W <= 0 || H <= 0) {
+		throw std::invalid_argument(
+				"\nrref::RrefCache::solve(double**, int, int)->"
+				"invalid size\n");
+	}
+
+	/*
+	   Rref would copy the matrix anyway,
+	   hash it during that copy
+	 */
+	std::vector<RowData> rows;
+	rows.reserve(H);
+	MatrixHash hasher;
+
+	for (int i = 0; i < H; i++) {
+		rows.push_back(RowData(matrix[i], W));
+		hasher.update(rows.back().data, W);
+	}
+
+	return solve(std::move(rows), hasher.digest(), pivoting, preprocess);
+}
+
+std::shared_ptr<const Rref> RrefCache::solve(std::vector<RowData>&& rows,
+		uint64_t hash, Rref::Pivoting pivoting, int preprocess) {
+	if (rows.empty()) {
+		throw std::invalid_argument(
+				"\nrref::RrefCache::solve(std::vector<RowData>&&)->"
+				"empty matrix\n");
+	}
+
+	Key key{hash, rows[0].W, (int)rows.size(), pivoting, preprocess};
+	std::shared_ptr<const Rref> result = find(key);
+
+	if (result) {
+		return result;
+	}
+
+	return insert(key, std::make_shared<const Rref>(
+			std::move(rows), pivoting, preprocess));
+}
+
+long RrefCache::hits() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return hitCount;
+}
+
+long RrefCache::misses() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return missCount;
+}
+
+size_t RrefCache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return lru.size();
+}
+
+size_t RrefCache::bytes() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return used;
+}
+
+void RrefCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	lru.clear();
+	index.clear();
+	used = 0;
+}
+
+std::shared_ptr<const Rref> RrefCache::find(const Key& key) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(key);
+
+	if (it == index.end()) {
+		missCount++;
+		return nullptr;
+	}
+
+	hitCount++;
+	lru.splice(lru.begin(), lru, it -> second);
+
+	return it -> second -> second;
+}
+
+std::shared_ptr<const Rref> RrefCache::insert(const Key& key,
+		std::shared_ptr<const Rref> result) {
+	size_t size = sizeOf(key.W, key.H);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(key);
+
+	if (it != index.end()) {
+		return it -> second -> second;
+	}
+
+	if (size > maxBytes) {
+		return result;
+	}
+
+	while (used + size > maxBytes) {
+		used -= sizeOf(lru.back().first.W, lru.back().first.H);
+		index.erase(lru.back().first);
+		lru.pop_back();
+	}
+
+	lru.emplace_front(key, result);
+	index[key] = lru.begin();
+	used += size;
+
+	return result;
+}
+
+size_t RrefCache::sizeOf(int W, int H) {
+	return sizeof(Rref) + sizeof(Lru::value_type)
+			+ (size_t)H * (sizeof(RowData) + W * sizeof(double));
+}
@@ -0,0 +1,177 @@
+#ifndef RREFCACHE_H_
+#define RREFCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Rref.h"
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * RrefCache.h                                                                                  *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   A bounded cache of solved matrices, for
+   inputs that repeat, such as templates
+   and retries.
+
+   Results are keyed by the MatrixHash of the
+   input (see MatrixHash.h), its shape and the
+   pivoting and preprocessing used. The hash is computed while the
+   input is parsed or copied, so a lookup costs
+   no extra pass over the data. On a miss the
+   matrix is solved and the result is kept.
+
+   When the results held take more than
+   maxBytes, the least recently used ones
+   are dropped. Results are shared, so a
+   dropped result stays valid for callers
+   still holding it.
+
+   All methods are thread safe. Solving is
+   done outside the lock.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class RrefCache {
+
+	public:
+
+		/*
+		   maxBytes-> max memory used by the
+		   cached results. Results larger than
+		   this are solved but not cached.
+		 */
+		explicit RrefCache(size_t maxBytes);
+
+		RrefCache(const RrefCache& other) = delete;
+		RrefCache& operator=(const RrefCache& other) = delete;
+
+		/*
+		   Same as Rref(std::string, Rref::Pivoting, int),
+		   but returns the cached result if
+		   the matrix was already solved.
+
+		   Throws:
+		   see Rref::parse(std::string, uint64_t*)
+		 */
+		std::shared_ptr<const Rref> solve(std::string url,
+				Rref::Pivoting pivoting = Rref::PARTIAL,
+				int preprocess = Rref::NONE);
+
+		/*
+		   Same as Rref(double**, int, int, Rref::Pivoting, int),
+		   but returns the cached result if
+		   the matrix was already solved.
+		 */
+		std::shared_ptr<const Rref> solve(double** matrix, int W, int H,
+				Rref::Pivoting pivoting = Rref::PARTIAL,
+				int preprocess = Rref::NONE);
+
+		/*
+		   Same as Rref(std::vector<RowData>&&, Rref::Pivoting, int),
+		   for rows already hashed by their reader
+		   (see MatrixReader::hash()). rows are
+		   only consumed on a miss.
+		 */
+		std::shared_ptr<const Rref> solve(std::vector<RowData>&& rows,
+				uint64_t hash, Rref::Pivoting pivoting = Rref::PARTIAL,
+				int preprocess = Rref::NONE);
+
+		/*
+		   Amount of lookups that found,
+		   or didn't find, a result
+		 */
+		long hits();
+		long misses();
+
+		/*
+		   Amount of results held and
+		   the memory they use
+		 */
+		size_t size();
+		size_t bytes();
+
+		/*
+		   Drops every result.
+		   Statistics are kept.
+		 */
+		void clear();
+
+	private:
+
+		struct Key {
+			uint64_t hash;
+			int W;
+			int H;
+			Rref::Pivoting pivoting;
+			int preprocess;
+
+			bool operator==(const Key& that) const;
+		};
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const;
+		};
+
+		typedef std::list<std::pair<Key, std::shared_ptr<const Rref>>> Lru;
+
+		/*
+		   Most recently used result first
+		 */
+		Lru lru;
+		std::unordered_map<Key, Lru::iterator, KeyHash> index;
+
+		size_t maxBytes;
+		size_t used;
+		long hitCount;
+		long missCount;
+		std::mutex mutex;
+
+		/*
+		   Returns the cached result and marks it
+		   as most recently used, or nullptr
+		 */
+		std::shared_ptr<const Rref> find(const Key& key);
+
+		/*
+		   Adds a result and drops the least
+		   recently used ones until it fits.
+		   Returns the result held for key, which
+		   is an older one if another thread
+		   inserted it first.
+		 */
+		std::shared_ptr<const Rref> insert(const Key& key,
+				std::shared_ptr<const Rref> result);
+
+		/*
+		   Approximate memory used by
+		   a solved W x H matrix
+		 */
+		static size_t sizeOf(int W, int H);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "BoundedQueue.h"
+#include "RrefPipeline.h"
+
+RrefPipeline::RrefPipeline(int capacity, Rref::Pivoting pivoting,
+		int preprocess, RrefCache* cache) {
+	if (capacity <= 0) {
+		throw std::invalid_argument(
+				"\nrref::RrefPipeline::RrefPipeline(int)->"
+				"invalid capacity\n");
+	}
+
+	this -> capacity = capacity;
+	this -> pivoting = pivoting;
+	this -> preprocess = preprocess;
+	this -> cache = cache;
+}
+
+/*
+   A matrix waiting to be solved,
+   with the hash computed while parsing it
+ */
+struct Parsed {
+	std::vector<RowData> rows;
+	uint64_t hash;
+};
+
+long RrefPipeline::run(MatrixReader& reader, MatrixWriter& writer) {
+	BoundedQueue<Parsed> parsed(capacity);
+	BoundedQueue<std::shared_ptr<const Rref>> solved(capacity);
+
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	/*
+	   Keeps the first error. Each stage then
+	   closes its output and the queues before it,
+	   so the stages before it stop, while the
+	   ones after it still drain what was queued
+	   before the error
+	 */
+	auto fail = [&]() {
+		std::lock_guard<std::mutex> lock(errorMutex);
+
+		if (!error) {
+			error = std::current_exception();
+		}
+	};
+
+	std::thread parse([&]() {
+		try {
+			std::vector<RowData> rows;
+
+			while (reader.next(rows)) {
+				if (!parsed.push(Parsed{std::move(rows), reader.hash()})) {
+					break;
+				}
+
+				rows = std::vector<RowData>();
+			}
+		} catch (...) {
+			fail();
+		}
+
+		parsed.close();
+	});
+
+	std::thread solve([&]() {
+		try {
+			Parsed matrix;
+
+			while (parsed.pop(matrix)) {
+				std::shared_ptr<const Rref> result = cache
+						? cache -> solve(std::move(matrix.rows),
+								matrix.hash, pivoting, preprocess)
+						: std::make_shared<const Rref>(
+								std::move(matrix.rows), pivoting,
+								preprocess);
+
+				if (!solved.push(std::move(result))) {
+					break;
+				}
+			}
+		} catch (...) {
+			fail();
+		}
+
+		parsed.close();
+
+		solved.close();
+	});
+
+	long count = 0;
+
+	try {
+		std::shared_ptr<const Rref> matrix;
+
+		while (solved.pop(matrix)) {
+			writer.write(*matrix);
+			count++;
+		}
+
+		writer.flush();
+	} catch (...) {
+		fail();
+	}
+
+	solved.close();
+	parsed.close();
+
+	parse.join();
+	solve.join();
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	return count;
+}
@@ -0,0 +1,100 @@
+#ifndef RREFPIPELINE_H_
+#define RREFPIPELINE_H_
+
+#include "MatrixReader.h"
+#include "MatrixWriter.h"
+#include "Rref.h"
+#include "RrefCache.h"
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * RrefPipeline.h                                                                               *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   Solves a stream of matrices.
+
+   run() splits the work into three stages,
+   each on its own thread:
+
+           -parse: MatrixReader::next() reads the
+           rows of the next matrix
+
+           -solve: the rows are moved into
+           Rref(std::vector<RowData>&&), which
+           converts them into rref without a copy
+
+           -format: the solved matrix is written out
+           by a MatrixWriter
+
+   Stages are connected by BoundedQueues
+   (see BoundedQueue.h), so parsing the next
+   matrix overlaps with solving and writing
+   the previous ones, while memory use stays
+   bounded by the queue capacity. Results are
+   written in input order.
+
+   If a cache is given, the solve stage looks each
+   matrix up by the hash computed while parsing it,
+   and only solves the ones it hasn't seen.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class RrefPipeline {
+
+	public:
+
+		/*
+		   capacity-> max amount of matrices
+		   waiting between two stages
+		   pivoting-> see Rref::Pivoting
+		   preprocess-> see Rref::Preprocess
+		   cache-> results to reuse, or nullptr.
+		   Not owned by the pipeline.
+		 */
+		explicit RrefPipeline(int capacity = 64,
+				Rref::Pivoting pivoting = Rref::PARTIAL,
+				int preprocess = Rref::NONE,
+				RrefCache* cache = nullptr);
+
+		/*
+		   Reads every matrix from reader, solves
+		   it and writes it to writer. The writer
+		   is flushed before returning.
+
+		   Returns:
+		   amount of matrices solved
+
+		   Throws:
+		   the first exception thrown by any stage,
+		   after all stages have stopped. The
+		   matrices read before a parse or solve
+		   error are still solved and written first
+		 */
+		long run(MatrixReader& reader, MatrixWriter& writer);
+
+	private:
+
+		int capacity;
+		Rref::Pivoting pivoting;
+		int preprocess;
+		RrefCache* cache;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "RrefSketch.h"
+
+RrefSketch::RrefSketch(int W, int rows, Kind kind, uint64_t seed)
+		: random(seed) {
+	if (W <= 0 || rows <= 0) {
+		throw std::invalid_argument(
+				"\nrref::RrefSketch::RrefSketch("
+				"int,int,Kind,uint64_t)->"
+				"invalid size\n");
+	}
+
+	this -> W = W;
+	height = rows;
+	this -> kind = kind;
+	added = 0;
+	solved = false;
+
+	sketch.reserve(rows);
+
+	for (int i = 0; i < rows; i++) {
+		sketch.emplace_back(W);
+	}
+}
+
+void RrefSketch::add(const double* row) {
+	if (solved) {
+		throw std::logic_error(
+				"\nrref::RrefSketch::add(const double*)->"
+				"sketch was already solved\n");
+	}
+
+	if (kind == GAUSSIAN) {
+		std::normal_distribution<double> normal;
+
+		for (int i = 0; i < height; i++) {
+			double weight = normal(random);
+			double* out = sketch[i].data;
+
+			for (int j = 0; j < W; j++) {
+				out[j] += weight * row[j];
+			}
+		}
+	} else {
+		std::uniform_int_distribution<int> pick(0, height - 1);
+
+		/*
+		   Rows hit twice just get the sum
+		   of both weights. The scale of S
+		   doesn't change the row space.
+		 */
+		for (int n = 0; n < NONZEROS; n++) {
+			uint64_t bits = random();
+			double* out = sketch[pick(random)].data;
+
+			if (bits & 1) {
+				for (int j = 0; j < W; j++) {
+					out[j] += row[j];
+				}
+			} else {
+				for (int j = 0; j < W; j++) {
+					out[j] -= row[j];
+				}
+			}
+		}
+	}
+
+	added++;
+}
+
+long RrefSketch::count() const {
+	return added;
+}
+
+Rref RrefSketch::solve(Rref::Pivoting pivoting) {
+	if (solved || added == 0) {
+		throw std::logic_error(
+				"\nrref::RrefSketch::solve(Rref::Pivoting)->"
+				"no rows to solve\n");
+	}
+
+	for (auto& row : sketch) {
+		row.setRowInfo();
+	}
+
+	solved = true;
+
+	return Rref(std::move(sketch), pivoting);
+}
+
+double RrefSketch::failureProbability(int rank) const {
+	int p = height - rank;
+
+	if (p < 3) {
+		return 1;
+	}
+
+	return std::min(1.0, 6 * std::pow((double)p, -p));
+}
@@ -0,0 +1,154 @@
+#ifndef RREFSKETCH_H_
+#define RREFSKETCH_H_
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Rref.h"
+#include "RowData.h"
+
+ /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * RrefSketch.h                                                                                 *
+ *                                                                                              *
+ * Copyright 2023 Trevor Lash                                                                   *
+ *                                                                                              *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of              *
+ * this software and associated documentation files (the Software), to deal in the            *
+ * Software without restriction, including without limitation the rights to use, copy,          *
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,          *
+ * and to permit persons to whom the Software is furnished to do so, subject to the             *
+ * following conditions: The above copyright notice and this permission notice shall be         *
+ * included in all copies or substantial portions of the Software.THE SOFTWARE IS PROVIDED      *
+ * AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED         *
+ * TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  *
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR      *
+ * IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+   Estimates the rank and a basis of the row
+   space of a tall H x W matrix without keeping
+   it in memory.
+
+   Rows are added one at a time and folded into
+   a sketch S * A of size rows x W, where S is a
+   random rows x H matrix. If rows >= rank + a few,
+   the sketch has the same row space as A with
+   high probability, so its rref holds the same
+   nonzero rows as the rref of A. Only the small
+   sketch is then reduced with Rref.
+
+   Two kinds of sketch are supported:
+
+           -SPARSE_SIGN: each row of A is added, with
+           a random sign, to NONZEROS random rows of
+           the sketch. O(NONZEROS * W) per row, the
+           choice for very large H.
+
+           -GAUSSIAN: each row of A is added to every
+           row of the sketch with a normal random
+           weight. O(rows * W) per row.
+
+   Author: Trevor Lash
+
+   Revised: 10/18/26
+ */
+class RrefSketch {
+
+	public:
+
+		enum Kind { SPARSE_SIGN, GAUSSIAN };
+
+		/*
+		   Nonzeros per column of S
+		   for SPARSE_SIGN sketches
+		 */
+		static const int NONZEROS = 8;
+
+		/*
+		   Parameters:
+		   W-> width of the matrix
+		   rows-> height of the sketch, an upper
+		   bound on the rank plus oversampling,
+		   e.g. min(W, expected rank) + 10
+		   kind-> see RrefSketch::Kind
+		   seed-> seed of the random sketch
+
+		   Throws:
+		   std::invalid_argument-> W <= 0 or rows <= 0
+		 */
+		RrefSketch(int W, int rows, Kind kind = SPARSE_SIGN,
+				uint64_t seed = 0);
+
+		/*
+		   Folds one row of A, of width W,
+		   into the sketch
+
+		   Throws:
+		   std::logic_error-> called after solve()
+		 */
+		void add(const double* row);
+
+		/*
+		   Amount of rows added
+		 */
+		long count() const;
+
+		/*
+		   Reduces the sketch. The sketch is moved
+		   into the result, so no more rows
+		   can be added afterwards.
+
+		   Throws:
+		   std::logic_error-> no rows were added,
+		   or called twice
+		 */
+		Rref solve(Rref::Pivoting pivoting = Rref::PARTIAL);
+
+		/*
+		   Bound on the probability that the sketch
+		   missed part of the row space, for a sketch
+		   whose rref has the given rank.
+
+		   With oversampling p = rows - rank, this is
+		   6 * p^-p, the bound of Halko, Martinsson and
+		   Tropp for Gaussian sketches: with at least
+		   that probability, no direction of the row space
+		   carrying more than a small multiple of the
+		   (rank + 1)th singular value was lost. It is
+		   used as an estimate for SPARSE_SIGN sketches.
+
+		   Returns 1 when p < 3, since the sketch
+		   may then be too small to see the whole rank.
+		 */
+		double failureProbability(int rank) const;
+
+	private:
+
+		int W;
+
+		/*
+		   Height of the sketch
+		 */
+		int height;
+
+		Kind kind;
+		long added;
+
+		/*
+		   True once the sketch was
+		   moved into an Rref
+		 */
+		bool solved;
+
+		/*
+		   The sketch S * A
+		 */
+		std::vector<RowData> sketch;
+
+		std::mt19937_64 random;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "MatrixReader.h"
+#include "MatrixWriter.h"
+#include "RrefPipeline.h"
+#include "RrefSketch.h"
+
+/*
+   Command line driver.
+
+   Reads matrices back to back from a file
+   or stdin, and writes their rref to stdout
+   in the same text format, one matrix per
+   block, separated by blank lines.
+
+   Usage: rref [-b] [-q capacity] [-p precision]
+               [-z clamp] [-r | -c] [-d] [-e] [-t] [-m bytes]
+               [-k rows [-g]] [file|-]
+
+           -b-> input is in the binary frame
+           format (see MatrixReader.h)
+
+           -q-> max amount of matrices queued
+           between pipeline stages
+
+           -p-> significant digits written (default 6)
+
+           -z-> numbers with |e| < clamp are
+           written as 0 (default 1E-9)
+
+           -r, -c-> rook or complete pivoting
+           instead of partial pivoting
+
+           -d-> drop zero, duplicate and multiple
+           rows before elimination
+
+           -e-> equilibrate rows and columns
+           before elimination
+
+           -t-> tournament pivoting for tall
+           matrices, on one block of rows per core
+
+           -m-> cache results of repeated matrices,
+           using at most this many bytes. Hits and
+           misses are reported on stderr
+
+           -k-> sketch mode. Each matrix is streamed
+           into a random sketch with this many rows
+           (see RrefSketch.h), and only the basis of
+           its row space is written. The rank and a
+           failure probability bound go to stderr.
+           rows must be > 0. Can't be combined
+           with -d, -e, -t or -m
+
+           -g-> Gaussian instead of sparse sign sketch
+ */
+static void usage() {
+	fprintf(stderr,
+			"usage: rref [-b] [-q capacity] [-p precision] "
+			"[-z clamp] [-r | -c] [-d] [-e] [-t] [-m bytes] "
+			"[-k rows [-g]] [file|-]\n");
+}
+
+/*
+   Sketch mode of the driver, rows are
+   read one at a time and never kept
+ */
+static void sketch(MatrixReader& reader, MatrixWriter& writer,
+		int size, RrefSketch::Kind kind, Rref::Pivoting pivoting) {
+	std::vector<double> row;
+
+	while (reader.nextRow(row)) {
+		RrefSketch sketch(row.size(), size, kind, reader.count());
+
+		do {
+			sketch.add(row.data());
+		} while (reader.nextRow(row));
+
+		Rref result = sketch.solve(pivoting);
+		int rank = result.rank();
+		const std::vector<RowData>& rows = result.getRows();
+
+		writer.write(rows.data() + rows.size() - rank, rank);
+		fprintf(stderr, "rank %d, failure probability <= %g\n",
+				rank, sketch.failureProbability(rank));
+	}
+
+	writer.flush();
+}
+
+int main(int argc, char** argv) {
+	MatrixReader::Format format = MatrixReader::TEXT;
+	int capacity = 64;
+	int precision = 6;
+	double clamp = 1E-9;
+	Rref::Pivoting pivoting = Rref::PARTIAL;
+	int preprocess = Rref::NONE;
+	long cacheBytes = 0;
+	int sketchRows = 0;
+	RrefSketch::Kind sketchKind = RrefSketch::SPARSE_SIGN;
+	std::string url = "-";
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-b")) {
+			format = MatrixReader::BINARY;
+		} else if (!strcmp(argv[i], "-q") && i + 1 < argc) {
+			capacity = std::atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+			precision = std::atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-z") && i + 1 < argc) {
+			clamp = std::atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			cacheBytes = std::atol(argv[++i]);
+		} else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+			sketchRows = std::atoi(argv[++i]);
+
+			if (sketchRows <= 0) {
+				usage();
+				return 2;
+			}
+		} else if (!strcmp(argv[i], "-g")) {
+			sketchKind = RrefSketch::GAUSSIAN;
+		} else if (!strcmp(argv[i], "-d")) {
+			preprocess |= Rref::DEDUPLICATE;
+		} else if (!strcmp(argv[i], "-e")) {
+			preprocess |= Rref::EQUILIBRATE;
+		} else if (!strcmp(argv[i], "-t")) {
+			preprocess |= Rref::TOURNAMENT;
+		} else if (!strcmp(argv[i], "-r")) {
+			pivoting = Rref::ROOK;
+		} else if (!strcmp(argv[i], "-c")) {
+			pivoting = Rref::COMPLETE;
+		} else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+			usage();
+			return 2;
+		} else {
+			url = argv[i];
+		}
+	}
+
+	/*
+	   The sketch is reduced as a whole, so
+	   there is nothing to preprocess or cache
+	 */
+	if (sketchRows > 0 && (preprocess != Rref::NONE || cacheBytes > 0)) {
+		usage();
+		return 2;
+	}
+
+	try {
+		MatrixReader reader(url, format);
+		MatrixWriter writer(STDOUT_FILENO, precision, clamp);
+
+		if (sketchRows > 0) {
+			sketch(reader, writer, sketchRows, sketchKind, pivoting);
+			return 0;
+		}
+
+		std::unique_ptr<RrefCache> cache;
+
+		if (cacheBytes > 0) {
+			cache = std::make_unique<RrefCache>(cacheBytes);
+		}
+
+		RrefPipeline pipeline(capacity, pivoting, preprocess,
+				cache.get());
+		pipeline.run(reader, writer);
+
+		if (cache) {
+			fprintf(stderr, "cache: %ld hits, %ld misses\n",
+					cache -> hits(), cache -> misses());
+		}
+	} catch (std::exception& e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}